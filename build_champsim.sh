@@ -87,17 +87,10 @@ else
 fi
 echo
 
-# Change prefetchers and replacement policy
-cp branch/${BRANCH}.bpred branch/branch_predictor.cc
-cp prefetcher/${L1D_PREFETCHER}.l1d_pref prefetcher/l1d_prefetcher.cc
-cp prefetcher/${L2C_PREFETCHER}.l2c_pref prefetcher/l2c_prefetcher.cc
-cp prefetcher/${LLC_PREFETCHER}.llc_pref prefetcher/llc_prefetcher.cc
-cp replacement/${LLC_REPLACEMENT}.llc_repl replacement/llc_replacement.cc
-
-# Build
+# Build, every component is compiled into one binary per core count, which is reused by all configurations.
+# make only recompiles what changed since the last build
 mkdir -p bin
 rm -f bin/champsim
-make clean
 make
 
 # Sanity check
@@ -105,8 +98,18 @@ echo ""
 if [ ! -f bin/champsim ]; then
     echo "${BOLD}ChampSim build FAILED!"
     echo ""
+    if [ "$NUM_CORE" -gt "1" ]; then
+        sed -i.bak 's/\<NUM_CPUS '${NUM_CORE}'\>/NUM_CPUS 1/g' inc/champsim.h
+    fi
     exit 1
 fi
+cp bin/champsim bin/champsim-${NUM_CORE}core
+
+# The configuration is selected at run time, the binary of a configuration only passes its components
+BINARY_NAME="${BRANCH}-${L1D_PREFETCHER}-${L2C_PREFETCHER}-${LLC_PREFETCHER}-${LLC_REPLACEMENT}-${NUM_CORE}core"
+echo '#!/bin/bash' > bin/${BINARY_NAME}
+echo 'exec "$(dirname "$0")/champsim-'${NUM_CORE}'core" -bpred '${BRANCH}' -l1d_pref '${L1D_PREFETCHER}' -l2c_pref '${L2C_PREFETCHER}' -llc_pref '${LLC_PREFETCHER}' -llc_repl '${LLC_REPLACEMENT}' "$@"' >> bin/${BINARY_NAME}
+chmod +x bin/${BINARY_NAME}
 
 echo "${BOLD}ChampSim is successfully built"
 echo "Branch Predictor: ${BRANCH}"
@@ -115,19 +118,13 @@ echo "L2C Prefetcher: ${L2C_PREFETCHER}"
 echo "LLC Prefetcher: ${LLC_PREFETCHER}"
 echo "LLC Replacement: ${LLC_REPLACEMENT}"
 echo "Cores: ${NUM_CORE}"
-BINARY_NAME="${BRANCH}-${L1D_PREFETCHER}-${L2C_PREFETCHER}-${LLC_PREFETCHER}-${LLC_REPLACEMENT}-${NUM_CORE}core"
 echo "Binary: bin/${BINARY_NAME}"
 echo ""
-mv bin/champsim bin/${BINARY_NAME}
 
 
-# Restore to the default configuration
-sed -i.bak 's/\<NUM_CPUS '${NUM_CORE}'\>/NUM_CPUS 1/g' inc/champsim.h
+# Restore to the default configuration, only when it was changed so that the next build does not recompile everything
+if [ "$NUM_CORE" -gt "1" ]; then
+    sed -i.bak 's/\<NUM_CPUS '${NUM_CORE}'\>/NUM_CPUS 1/g' inc/champsim.h
+fi
 #sed -i.bak 's/\<DRAM_CHANNELS 2\>/DRAM_CHANNELS 1/g' inc/champsim.h
 #sed -i.bak 's/\<DRAM_CHANNELS_LOG2 1\>/DRAM_CHANNELS_LOG2 0/g' inc/champsim.h
-
-cp branch/bimodal.bpred branch/branch_predictor.cc
-cp prefetcher/no.l1d_pref prefetcher/l1d_prefetcher.cc
-cp prefetcher/no.l2c_pref prefetcher/l2c_prefetcher.cc
-cp prefetcher/no.llc_pref prefetcher/llc_prefetcher.cc
-cp replacement/lru.llc_repl replacement/llc_replacement.cc
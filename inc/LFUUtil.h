@@ -171,8 +171,8 @@ public:
                 // 当满足了一定的 reused ratio 的时候
                 // 对于 reused ratio 极低的情况考虑不加入 ART
                 // 否则需要提前将本应该直接 bypass 的指令加入到 ART 中
-                if(PCRT[pc_index].reused * 64 > PCRT[pc_index].not_reused
-                    && PCRT[pc_index].reused * 3 < PCRT[pc_index].not_reused
+                if((PCRT[pc_index].reused * 64 > PCRT[pc_index].not_reused
+                    && PCRT[pc_index].reused * 3 < PCRT[pc_index].not_reused)
                     || (misses % 8 == 0)) {
                     ART_add_block(ip, block);
                 }
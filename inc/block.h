@@ -60,47 +60,48 @@ class DRAM_ARRAY {
     };
 };
 
-// message packet
-class PACKET {
+// the requests merged into a packet, by the ROB, LQ and SQ index that waits for it
+class DEPENDENT_SETS {
   public:
-    uint8_t instruction, 
-            tlb_access,
-            scheduled,
-            translated,
-            fetched,
-            prefetched,
-            drc_tag_read;
+    fastset rob_index_depend_on_me,
+            lq_index_depend_on_me,
+            sq_index_depend_on_me;
+};
 
-    int fill_level, 
-        pf_origin_level,
-        rob_signal, 
-        rob_index, 
-        producer,
-        delta,
-        depth,
-        signature,
-        confidence;
+// few packets ever have a merged request, so their sets are only allocated on the first merge.
+// the packet is still copied by value, a copy gets sets of its own
+class DEPENDENT_SETS_POINTER {
+  public:
+    DEPENDENT_SETS *sets;
 
-    uint32_t pf_metadata;
+    DEPENDENT_SETS_POINTER() {
+        sets = NULL;
+    };
 
-    uint8_t  is_producer, 
-             //rob_index_depend_on_me[ROB_SIZE], 
-             //lq_index_depend_on_me[ROB_SIZE], 
-             //sq_index_depend_on_me[ROB_SIZE], 
-             instr_merged,
-             load_merged, 
-             store_merged,
-             returned,
-             asid[2],
-             type;
+    DEPENDENT_SETS_POINTER(const DEPENDENT_SETS_POINTER &other) {
+        sets = other.sets ? new DEPENDENT_SETS(*other.sets) : NULL;
+    };
 
-    fastset
-             rob_index_depend_on_me, 
-             lq_index_depend_on_me, 
-             sq_index_depend_on_me;
+    DEPENDENT_SETS_POINTER &operator=(const DEPENDENT_SETS_POINTER &other) {
+        if (other.sets == NULL) {
+            delete sets;
+            sets = NULL;
+        }
+        else if (sets)
+            *sets = *other.sets;
+        else
+            sets = new DEPENDENT_SETS(*other.sets);
+        return *this;
+    };
 
-    uint32_t cpu, data_index, lq_index, sq_index;
+    ~DEPENDENT_SETS_POINTER() {
+        delete sets;
+    };
+};
 
+// message packet, the fields are ordered by size so that there is no padding between them
+class PACKET {
+  public:
     uint64_t address, 
              full_addr, 
              instruction_pa,
@@ -111,14 +112,32 @@ class PACKET {
              event_cycle,
              cycle_enqueued;
 
+    DEPENDENT_SETS_POINTER depend_on_me;
+
+    int fill_level, 
+        pf_origin_level,
+        rob_index, 
+        delta,
+        depth,
+        signature,
+        confidence;
+
+    uint32_t pf_metadata, cpu, lq_index, sq_index;
+
+    uint8_t instruction, 
+            tlb_access,
+            scheduled,
+            instr_merged,
+            load_merged, 
+            store_merged,
+            returned,
+            asid[2],
+            type;
+
     PACKET() {
         instruction = 0;
         tlb_access = 0;
         scheduled = 0;
-        translated = 0;
-        fetched = 0;
-        prefetched = 0;
-        drc_tag_read = 0;
 
         returned = 0;
         asid[0] = UINT8_MAX;
@@ -126,40 +145,254 @@ class PACKET {
         type = 0;
 
         fill_level = -1; 
-        rob_signal = -1;
+        pf_origin_level = 0;
         rob_index = -1;
-        producer = -1;
         delta = 0;
         depth = 0;
         signature = 0;
         confidence = 0;
 
-#if 0
-        for (uint32_t i=0; i<ROB_SIZE; i++) {
-            rob_index_depend_on_me[i] = 0;
-            lq_index_depend_on_me[i] = 0;
-            sq_index_depend_on_me[i] = 0;
-        }
-#endif
-        is_producer = 0;
         instr_merged = 0;
         load_merged = 0;
         store_merged = 0;
 
+        pf_metadata = 0;
         cpu = NUM_CPUS;
-        data_index = 0;
         lq_index = 0;
         sq_index = 0;
 
         address = 0;
         full_addr = 0;
         instruction_pa = 0;
+        data_pa = 0;
         data = 0;
         instr_id = 0;
         ip = 0;
         event_cycle = UINT64_MAX;
 	cycle_enqueued = 0;
     };
+
+    // the sets of merged requests, allocated by the first merge
+    DEPENDENT_SETS &dependents() {
+        if (depend_on_me.sets == NULL)
+            depend_on_me.sets = new DEPENDENT_SETS;
+        return *depend_on_me.sets;
+    };
+};
+
+// packets are allocated in chunks of this many
+#define PACKET_POOL_CHUNK 1024
+
+// the arena all queue packets come from, with the packets that no queue holds on a free list.
+// queues only take and give back packets when they are sized, before the simulation starts
+class PACKET_POOL {
+  public:
+    PACKET **free_packet;
+    uint32_t num_free, num_packets;
+
+    PACKET *allocate() {
+        if (num_free == 0)
+            grow();
+        return free_packet[--num_free];
+    };
+
+    void release(PACKET *packet) {
+        PACKET empty_packet;
+        *packet = empty_packet;
+        free_packet[num_free++] = packet;
+    };
+
+    void grow();
+};
+
+// no constructor, it is zero-initialized before any queue is constructed
+extern PACKET_POOL packet_pool;
+
+// the packets of a queue by position, entry[i] is the packet at position i
+class PACKET_SLOTS {
+  public:
+    PACKET **packet;
+
+    PACKET &operator[](uint32_t index) {
+        return *packet[index];
+    };
+};
+
+// what check_queue() matches a packet by
+#define QUEUE_MATCH_NONE      0 // the queue is never searched
+#define QUEUE_MATCH_ADDRESS   1 // block address
+#define QUEUE_MATCH_FULL_ADDR 2
+
+// a value of type T per address, hashed with linear probing. address 0 marks the empty slots and is never stored
+template <class T> class ADDRESS_TABLE {
+  public:
+    uint64_t *address;
+    T *value;
+    uint32_t log2_size;
+
+    ADDRESS_TABLE() {
+        address = NULL;
+        value = NULL;
+        log2_size = 0;
+    };
+
+    ~ADDRESS_TABLE() {
+        delete[] address;
+        delete[] value;
+    };
+
+    // at most half full with the given number of addresses
+    void resize(uint32_t entries) {
+        delete[] address;
+        delete[] value;
+
+        log2_size = 4;
+        while ((1u << log2_size) < 2*entries)
+            log2_size++;
+        address = new uint64_t[1 << log2_size]();
+        value = new T[1 << log2_size]();
+    };
+
+    void clear() {
+        memset(address, 0, sizeof(uint64_t) << log2_size);
+    };
+
+    uint32_t home(uint64_t addr) {
+        return (addr * 0x9E3779B97F4A7C15ull) >> (64 - log2_size);
+    };
+
+    // the slot holding the address, or the empty slot it would go to
+    uint32_t slot(uint64_t addr) {
+        uint32_t mask = (1 << log2_size) - 1, i = home(addr);
+        while (address[i] && (address[i] != addr))
+            i = (i + 1) & mask;
+        return i;
+    };
+
+    // the value of the address, NULL if the table does not hold it
+    T *find(uint64_t addr) {
+        uint32_t i = slot(addr);
+        return address[i] ? &value[i] : NULL;
+    };
+
+    // the value of the address, a new one if the table did not hold it
+    T &insert(uint64_t addr) {
+        uint32_t i = slot(addr);
+        if (address[i] == 0) {
+            address[i] = addr;
+            value[i] = T();
+        }
+        return value[i];
+    };
+
+    // empties a slot found by slot(). the following entries are shifted back so that no probe sequence is broken:
+    // an entry at j moves to the hole at i unless its home lies in (i, j], which wraps around the end of the table
+    void erase_slot(uint32_t i) {
+        uint32_t mask = (1 << log2_size) - 1;
+        for (uint32_t j = (i + 1) & mask; address[j]; j = (j + 1) & mask) {
+            uint32_t h = home(address[j]);
+            if ((i < j) ? ((h <= i) || (h > j)) : ((h <= i) && (h > j))) {
+                address[i] = address[j];
+                value[i] = value[j];
+                i = j;
+            }
+        }
+        address[i] = 0;
+    };
+};
+
+// the number of queue entries to each address, address 0 is never counted
+class ADDRESS_COUNT {
+  public:
+    ADDRESS_TABLE<uint32_t> count;
+
+    void resize(uint32_t entries) {
+        count.resize(entries);
+    };
+
+    uint32_t find(uint64_t addr) {
+        uint32_t *entries = count.find(addr);
+        return entries ? *entries : 0;
+    };
+
+    void insert(uint64_t addr) {
+        if (addr)
+            count.insert(addr)++;
+    };
+
+    void erase(uint64_t addr) {
+        if (addr == 0)
+            return;
+
+        uint32_t i = count.slot(addr);
+        if (count.address[i] && (--count.value[i] == 0))
+            count.erase_slot(i);
+    };
+};
+
+// the MSHR entries by address, the free ones, and the returned ones ordered by the cycle they fill at,
+// so that neither a lookup, an allocation nor picking the next fill scans the MSHR.
+// allocation takes the lowest free entry and fills of the same cycle go in entry order, like a scan would
+class MSHR_INDEX {
+  public:
+    uint32_t size, num_fills;
+
+    // the entry of each address, address 0 is never stored
+    ADDRESS_TABLE<uint32_t> entry_of;
+
+    // one bit per free entry
+    uint64_t *free_entry;
+
+    // binary min-heap of returned entries, fill_position is UINT32_MAX for the others
+    uint32_t *fill, *fill_position;
+    uint64_t *fill_cycle;
+
+    MSHR_INDEX() {
+        size = 0;
+        num_fills = 0;
+        free_entry = NULL;
+        fill = NULL;
+        fill_position = NULL;
+        fill_cycle = NULL;
+    };
+
+    ~MSHR_INDEX() {
+        release();
+    };
+
+    // the entry holding the address, -1 if there is none
+    int find(uint64_t addr) {
+        uint32_t *entry = entry_of.find(addr);
+        return entry ? (int)*entry : -1;
+    };
+
+    // the lowest free entry, size if the MSHR is full
+    uint32_t first_free() {
+        for (uint32_t i=0; i<(size+63)/64; i++) {
+            if (free_entry[i])
+                return i*64 + __builtin_ctzll(free_entry[i]);
+        }
+        return size;
+    };
+
+    // the returned entry to fill next, size if there is none
+    uint32_t next_fill() {
+        return num_fills ? fill[0] : size;
+    };
+
+    uint8_t earlier(uint32_t a, uint32_t b) {
+        return (fill_cycle[a] < fill_cycle[b]) || ((fill_cycle[a] == fill_cycle[b]) && (a < b));
+    };
+
+    void resize(uint32_t entries),
+         release(),
+         insert(uint64_t addr, uint32_t index),
+         erase(uint64_t addr, uint32_t index),
+         update_fill(uint32_t index, uint64_t cycle),
+         remove_fill(uint32_t index),
+         place_fill(uint32_t index, uint32_t position),
+         sift_up(uint32_t position),
+         sift_down(uint32_t position);
 };
 
 // packet queue
@@ -170,7 +403,8 @@ class PACKET_QUEUE {
 
     uint8_t  is_RQ, 
              is_WQ,
-             write_mode;
+             write_mode,
+             match;
 
     uint32_t cpu, 
              head, 
@@ -192,13 +426,18 @@ class PACKET_QUEUE {
              ROW_BUFFER_MISS,
              FULL;
 
-    PACKET *entry, processed_packet[2*MAX_READ_PER_CYCLE];
+    // a packet handed over to another queue changes hands instead of being copied, see move_queue()
+    PACKET_SLOTS entry;
+
+    // the entries by the address check_queue() matches, only kept when the queue has a match mode
+    ADDRESS_COUNT address_count;
 
     // constructor
     PACKET_QUEUE(string v1, uint32_t v2) : NAME(v1), SIZE(v2) {
         is_RQ = 0;
         is_WQ = 0;
         write_mode = 0;
+        match = QUEUE_MATCH_NONE;
 
         cpu = 0; 
         head = 0;
@@ -221,12 +460,15 @@ class PACKET_QUEUE {
         ROW_BUFFER_MISS = 0;
         FULL = 0;
 
-        entry = new PACKET[SIZE]; 
+        allocate();
     };
 
     PACKET_QUEUE() {
+        SIZE = 0;
         is_RQ = 0;
         is_WQ = 0;
+        write_mode = 0;
+        match = QUEUE_MATCH_NONE;
 
         cpu = 0; 
         head = 0;
@@ -249,25 +491,145 @@ class PACKET_QUEUE {
         ROW_BUFFER_MISS = 0;
         FULL = 0;
 
-        //entry = new PACKET[SIZE]; 
+        entry.packet = NULL;
     };
 
     // destructor
     ~PACKET_QUEUE() {
-        delete[] entry;
+        release();
+    };
+
+    // only before the simulation starts, the queue has to be empty
+    void resize(uint32_t size) {
+        assert(occupancy == 0);
+
+        release();
+        SIZE = size;
+        allocate();
+        if (match != QUEUE_MATCH_NONE)
+            address_count.resize(SIZE);
+
+        head = 0;
+        tail = 0;
+        next_fill_index = 0;
+        next_schedule_index = 0;
+        next_process_index = 0;
+    };
+
+    // only before the simulation starts, the queue has to be empty
+    void set_match(uint8_t mode) {
+        assert(occupancy == 0);
+
+        match = mode;
+        if (match != QUEUE_MATCH_NONE)
+            address_count.resize(SIZE);
+    };
+
+    uint64_t match_address(PACKET &packet) {
+        return (match == QUEUE_MATCH_FULL_ADDR) ? packet.full_addr : packet.address;
+    };
+
+    // counts the entry at index, for the callers that fill the tail themselves
+    void index_entry(uint32_t index) {
+        if (match != QUEUE_MATCH_NONE)
+            address_count.insert(match_address(entry[index]));
     };
 
     // functions
     int check_queue(PACKET* packet);
     void add_queue(PACKET* packet),
-         remove_queue(PACKET* packet);
+         move_queue(PACKET_QUEUE &source, uint32_t index),
+         remove_queue(PACKET* packet),
+         allocate(),
+         release();
+};
+
+// a set of ROB or load queue indices, one bit each
+class INDEX_SET {
+  public:
+    uint64_t bits[MAX_ROB_SIZE/64];
+
+    INDEX_SET() {
+        clear();
+    };
+
+    void clear() {
+        memset(bits, 0, sizeof(bits));
+    };
+
+    void insert(uint32_t index) {
+        bits[index >> 6] |= 1ull << (index & 63);
+    };
+
+    void erase(uint32_t index) {
+        bits[index >> 6] &= ~(1ull << (index & 63));
+    };
+
+    // first member in [begin, end), end if there is none
+    uint32_t find(uint32_t begin, uint32_t end) {
+        if (begin >= end)
+            return end;
+
+        uint32_t word = begin >> 6;
+        uint64_t remaining = bits[word] & (~0ull << (begin & 63));
+        while (remaining == 0) {
+            word++;
+            if ((word << 6) >= end)
+                return end;
+            remaining = bits[word];
+        }
+
+        uint32_t index = (word << 6) + __builtin_ctzll(remaining);
+        return (index < end) ? index : end;
+    };
+};
+
+// the latest cycle below each node of a tree over the ROB indices, so the first ROB entry
+// waiting past a given cycle is found without visiting the entries before it
+class ROB_CYCLE_TREE {
+  public:
+    uint64_t node[2*MAX_ROB_SIZE];
+
+    ROB_CYCLE_TREE() {
+        clear();
+    };
+
+    void clear() {
+        memset(node, 0, sizeof(node));
+    };
+
+    void update(uint32_t index, uint64_t cycle) {
+        uint32_t i = MAX_ROB_SIZE + index;
+        node[i] = cycle;
+        for (i >>= 1; i; i >>= 1)
+            node[i] = (node[2*i] > node[2*i+1]) ? node[2*i] : node[2*i+1];
+    };
+
+    // first index in [begin, end) whose cycle is later than the given one, end if there is none
+    uint32_t find_later(uint32_t begin, uint32_t end, uint64_t cycle) {
+        uint32_t found = find_later(1, 0, MAX_ROB_SIZE, begin, end, cycle);
+        return (found < end) ? found : end;
+    };
+
+    uint32_t find_later(uint32_t i, uint32_t low, uint32_t high, uint32_t begin, uint32_t end, uint64_t cycle) {
+        if ((high <= begin) || (end <= low) || (node[i] <= cycle))
+            return UINT32_MAX;
+        if (high - low == 1)
+            return low;
+
+        uint32_t middle = (low + high) / 2,
+                 found = find_later(2*i, low, middle, begin, end, cycle);
+        if (found != UINT32_MAX)
+            return found;
+        return find_later(2*i+1, middle, high, begin, end, cycle);
+    };
 };
 
 // reorder buffer
 class CORE_BUFFER {
   public:
     const string NAME;
-    const uint32_t SIZE;
+    uint32_t SIZE;
     uint32_t cpu, 
              head, 
              tail,
@@ -315,6 +677,53 @@ class CORE_BUFFER {
     ~CORE_BUFFER() {
         delete[] entry;
     };
+
+    // only before the simulation starts, the buffer has to be empty
+    void resize(uint32_t size) {
+        assert(occupancy == 0);
+
+        delete[] entry;
+        SIZE = size;
+        entry = new ooo_model_instr[SIZE];
+
+        head = 0;
+        tail = 0;
+        last_read = SIZE-1;
+        last_fetch = SIZE-1;
+        last_scheduled = 0;
+    };
+};
+
+// the youngest store in the ROB to each address, there are at most MAX_ROB_SIZE*NUM_INSTR_DESTINATIONS_SPARC
+class STORE_INDEX {
+  public:
+    ADDRESS_TABLE<ROB_WRITER> store;
+
+    STORE_INDEX() {
+        store.resize(MAX_ROB_SIZE * NUM_INSTR_DESTINATIONS_SPARC);
+    };
+
+    void clear() {
+        store.clear();
+    };
+
+    ROB_WRITER find(uint64_t addr) {
+        ROB_WRITER *youngest = store.find(addr);
+        return youngest ? *youngest : ROB_WRITER();
+    };
+
+    void insert(uint64_t addr, uint32_t rob_index, uint64_t instr_id) {
+        ROB_WRITER &youngest = store.insert(addr);
+        youngest.rob_index = rob_index;
+        youngest.instr_id = instr_id;
+    };
+
+    // only if the given store is still the youngest one to the address
+    void erase(uint64_t addr, uint32_t rob_index, uint64_t instr_id) {
+        uint32_t i = store.slot(addr);
+        if (store.address[i] && (store.value[i].rob_index == rob_index) && (store.value[i].instr_id == instr_id))
+            store.erase_slot(i);
+    };
 };
 
 // load/store queue 
@@ -364,7 +773,7 @@ class LSQ_ENTRY {
 class LOAD_STORE_QUEUE {
   public:
     const string NAME;
-    const uint32_t SIZE;
+    uint32_t SIZE;
     uint32_t occupancy, head, tail;
 
     LSQ_ENTRY *entry;
@@ -382,5 +791,17 @@ class LOAD_STORE_QUEUE {
     ~LOAD_STORE_QUEUE() {
         delete[] entry;
     };
+
+    // only before the simulation starts, the queue has to be empty
+    void resize(uint32_t size) {
+        assert(occupancy == 0);
+
+        delete[] entry;
+        SIZE = size;
+        entry = new LSQ_ENTRY[SIZE];
+
+        head = 0;
+        tail = 0;
+    };
 };
 #endif
@@ -1,11 +1,41 @@
 #ifndef CACHE_H
 #define CACHE_H
 
+#include <mutex>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "memory_class.h"
+#include "component.h"
+
+// the tag mirror of a way without a valid block, block addresses and page numbers never reach it
+#define INVALID_TAG UINT64_MAX
 
 // PAGE
 extern uint32_t PAGE_TABLE_LATENCY, SWAP_LATENCY;
 
+// PREFETCHER
+// prefetchers may keep tables shared by all cores, so calls from the private caches
+// are serialized when -sync_quantum runs the cores on several threads
+extern std::mutex prefetcher_mutex;
+
+class PREFETCHER_LOCK {
+  public:
+    uint8_t locked;
+
+    PREFETCHER_LOCK() {
+        locked = (knob_sync_quantum && (knob_threads > 1));
+        if (locked)
+            prefetcher_mutex.lock();
+    };
+
+    ~PREFETCHER_LOCK() {
+        if (locked)
+            prefetcher_mutex.unlock();
+    };
+};
+
 // CACHE TYPE
 #define IS_ITLB 0
 #define IS_DTLB 1
@@ -78,15 +108,29 @@ extern uint32_t PAGE_TABLE_LATENCY, SWAP_LATENCY;
 #define LLC_MSHR_SIZE NUM_CPUS*64
 #define LLC_LATENCY 20  // 5 (L1I or L1D) + 10 + 20 = 34 cycles
 
+// the geometry of one cache level, initialized with the macros above and changed by -config
+class CACHE_CONFIG {
+  public:
+    uint32_t sets, ways, rq_size, wq_size, pq_size, mshr_size, latency;
+};
+
+extern CACHE_CONFIG itlb_config, dtlb_config, stlb_config,
+                    l1i_config, l1d_config, l2c_config, llc_config;
+
 void print_cache_config();
 
 class CACHE : public MEMORY {
   public:
     uint32_t cpu;
     const string NAME;
-    const uint32_t NUM_SET, NUM_WAY, NUM_LINE, WQ_SIZE, RQ_SIZE, PQ_SIZE, MSHR_SIZE;
+    uint32_t NUM_SET, NUM_WAY, NUM_LINE, WQ_SIZE, RQ_SIZE, PQ_SIZE, MSHR_SIZE;
     uint32_t LATENCY;
     BLOCK **block;
+    uint32_t set_mask; // the set index bits of a block address
+
+    // the tag of each valid block and INVALID_TAG for the others, the ways of a set next to each other.
+    // lookups compare a set here in a few vector compares without touching the blocks
+    uint64_t *way_tag;
     int fill_level;
     uint32_t MAX_READ, MAX_FILL;
     uint32_t reads_available_this_cycle;
@@ -107,6 +151,9 @@ class CACHE : public MEMORY {
                  MSHR{NAME + "_MSHR", MSHR_SIZE}, // MSHR
                  PROCESSED{NAME + "_PROCESSED", ROB_SIZE}; // processed queue
 
+    // MSHR lookup, allocation and fill order
+    MSHR_INDEX mshr_lookup;
+
     uint64_t sim_access[NUM_CPUS][NUM_TYPES],
              sim_hit[NUM_CPUS][NUM_TYPES],
              sim_miss[NUM_CPUS][NUM_TYPES],
@@ -131,6 +178,8 @@ class CACHE : public MEMORY {
                 block[i][j].lru = j;
             }
         }
+        set_mask = (1 << lg2(NUM_SET)) - 1;
+        allocate_tags();
 
         for (uint32_t i=0; i<NUM_CPUS; i++) {
             upper_level_icache[i] = NULL;
@@ -160,6 +209,11 @@ class CACHE : public MEMORY {
         pf_useless = 0;
         pf_late = 0;
         pf_fill = 0;
+
+        WQ.set_match(QUEUE_MATCH_ADDRESS);
+        RQ.set_match(QUEUE_MATCH_ADDRESS);
+        PQ.set_match(QUEUE_MATCH_ADDRESS);
+        mshr_lookup.resize(MSHR_SIZE);
     };
 
     // destructor
@@ -167,6 +221,21 @@ class CACHE : public MEMORY {
         for (uint32_t i=0; i<NUM_SET; i++)
             delete[] block[i];
         delete[] block;
+        delete[] way_tag;
+    };
+
+    // mirrors block[set][way] after its valid bit or tag changed
+    void update_tag(uint32_t set, uint32_t way) {
+        way_tag[set*NUM_WAY + way] = block[set][way].valid ? block[set][way].tag : INVALID_TAG;
+    };
+
+    // for the current geometry, with the blocks as they are
+    void allocate_tags() {
+        way_tag = new uint64_t[NUM_SET*NUM_WAY];
+        for (uint32_t set=0; set<NUM_SET; set++) {
+            for (uint32_t way=0; way<NUM_WAY; way++)
+                update_tag(set, way);
+        }
     };
 
     // functions
@@ -181,16 +250,30 @@ class CACHE : public MEMORY {
     uint32_t get_occupancy(uint8_t queue_type, uint64_t address),
              get_size(uint8_t queue_type, uint64_t address);
 
+    uint64_t get_next_event_cycle();
+
+    void functional_access(PACKET *packet),
+         configure(const CACHE_CONFIG &config);
+
+    uint32_t get_set(uint64_t address) {
+        return (uint32_t) (address & set_mask);
+    };
+
+    uint32_t find_tag(uint32_t set, uint64_t tag);
+
     int  check_hit(PACKET *packet),
          invalidate_entry(uint64_t inval_addr),
          check_mshr(PACKET *packet),
          prefetch_line(uint64_t ip, uint64_t base_addr, uint64_t pf_addr, int prefetch_fill_level, uint32_t prefetch_metadata),
          kpc_prefetch_line(uint64_t base_addr, uint64_t pf_addr, int prefetch_fill_level, int delta, int depth, int signature, int confidence, uint32_t prefetch_metadata);
 
-    void handle_fill(),
-         handle_writeback(),
-         handle_read(),
-         handle_prefetch();
+    // compiled once per cache type, CACHE_TYPE stands in for cache_type so that the checks of it fold away.
+    // operate() picks the instance for this cache
+    template <uint8_t CACHE_TYPE> void operate_as();
+    template <uint8_t CACHE_TYPE> void handle_fill();
+    template <uint8_t CACHE_TYPE> void handle_writeback();
+    template <uint8_t CACHE_TYPE> void handle_read();
+    template <uint8_t CACHE_TYPE> void handle_prefetch();
 
     void add_mshr(PACKET *packet),
          update_fill_cycle(),
@@ -221,11 +304,31 @@ class CACHE : public MEMORY {
 
     void prefetcher_feedback(uint64_t &pref_gen, uint64_t &pref_fill, uint64_t &pref_used, uint64_t &pref_late);
     
-    uint32_t get_set(uint64_t address),
-             get_way(uint64_t address, uint32_t set),
+    uint32_t get_way(uint64_t address, uint32_t set),
              find_victim(uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type),
              llc_find_victim(uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type),
              lru_victim(uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type);
 };
 
+// prefetcher and LLC replacement hooks go to the components selected at run time
+inline void CACHE::l1d_prefetcher_initialize() { CALL_COMPONENT(L1D_PREFETCHERS, l1d_prefetcher, l1d_prefetcher_initialize(*this)); }
+inline void CACHE::l1d_prefetcher_operate(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type) { CALL_COMPONENT(L1D_PREFETCHERS, l1d_prefetcher, l1d_prefetcher_operate(*this, addr, ip, cache_hit, type)); }
+inline void CACHE::l1d_prefetcher_cache_fill(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in) { CALL_COMPONENT(L1D_PREFETCHERS, l1d_prefetcher, l1d_prefetcher_cache_fill(*this, addr, set, way, prefetch, evicted_addr, metadata_in)); }
+inline void CACHE::l1d_prefetcher_final_stats() { CALL_COMPONENT(L1D_PREFETCHERS, l1d_prefetcher, l1d_prefetcher_final_stats(*this)); }
+
+inline void CACHE::l2c_prefetcher_initialize() { CALL_COMPONENT(L2C_PREFETCHERS, l2c_prefetcher, l2c_prefetcher_initialize(*this)); }
+inline uint32_t CACHE::l2c_prefetcher_operate(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in) { CALL_COMPONENT(L2C_PREFETCHERS, l2c_prefetcher, l2c_prefetcher_operate(*this, addr, ip, cache_hit, type, metadata_in)); return 0; }
+inline uint32_t CACHE::l2c_prefetcher_cache_fill(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in) { CALL_COMPONENT(L2C_PREFETCHERS, l2c_prefetcher, l2c_prefetcher_cache_fill(*this, addr, set, way, prefetch, evicted_addr, metadata_in)); return 0; }
+inline void CACHE::l2c_prefetcher_final_stats() { CALL_COMPONENT(L2C_PREFETCHERS, l2c_prefetcher, l2c_prefetcher_final_stats(*this)); }
+
+inline void CACHE::llc_prefetcher_initialize() { CALL_COMPONENT(LLC_PREFETCHERS, llc_prefetcher, llc_prefetcher_initialize(*this)); }
+inline uint32_t CACHE::llc_prefetcher_operate(uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in) { CALL_COMPONENT(LLC_PREFETCHERS, llc_prefetcher, llc_prefetcher_operate(*this, addr, ip, cache_hit, type, metadata_in)); return 0; }
+inline uint32_t CACHE::llc_prefetcher_cache_fill(uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in) { CALL_COMPONENT(LLC_PREFETCHERS, llc_prefetcher, llc_prefetcher_cache_fill(*this, addr, set, way, prefetch, evicted_addr, metadata_in)); return 0; }
+inline void CACHE::llc_prefetcher_final_stats() { CALL_COMPONENT(LLC_PREFETCHERS, llc_prefetcher, llc_prefetcher_final_stats(*this)); }
+
+inline void CACHE::llc_initialize_replacement() { CALL_COMPONENT(LLC_REPLACEMENTS, llc_replacement, llc_initialize_replacement(*this)); }
+inline uint32_t CACHE::llc_find_victim(uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type) { CALL_COMPONENT(LLC_REPLACEMENTS, llc_replacement, llc_find_victim(*this, cpu, instr_id, set, current_set, ip, full_addr, type)); return 0; }
+inline void CACHE::llc_update_replacement_state(uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type, uint8_t hit) { CALL_COMPONENT(LLC_REPLACEMENTS, llc_replacement, llc_update_replacement_state(*this, cpu, set, way, full_addr, ip, victim_addr, type, hit)); }
+inline void CACHE::llc_replacement_final_stats() { CALL_COMPONENT(LLC_REPLACEMENTS, llc_replacement, llc_replacement_final_stats(*this)); }
+
 #endif
@@ -17,6 +17,7 @@
 #include <map>
 #include <random>
 #include <string>
+#include <sstream>
 #include <iomanip>
 
 // USEFUL MACROS
@@ -79,7 +80,11 @@ extern uint8_t warmup_complete[NUM_CPUS],
                all_simulation_complete,
                MAX_INSTR_DESTINATIONS,
                knob_cloudsuite,
-               knob_low_bandwidth;
+               knob_low_bandwidth,
+               knob_event_skip;
+
+extern uint32_t knob_threads,
+                knob_sync_quantum;
 
 extern uint64_t current_core_cycle[NUM_CPUS], 
                 stall_cycle[NUM_CPUS], 
@@ -114,5 +119,6 @@ class RANDOM {
         return dist(engine);
     };
 };
+extern RANDOM champsim_rand;
 extern uint64_t champsim_seed;
 #endif
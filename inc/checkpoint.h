@@ -0,0 +1,44 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+
+#include "champsim.h"
+
+#define CHECKPOINT_MAGIC 0x54504b4348504d43 // "CMPHCKPT"
+#define CHECKPOINT_VERSION 1
+
+// plain memory owned by a branch predictor or replacement policy that is saved with the warmed-up state
+class CHECKPOINT_REGION {
+  public:
+    string component,
+           name;
+    void *addr;
+    uint64_t size;
+};
+
+vector<CHECKPOINT_REGION> &checkpoint_regions();
+
+class CHECKPOINT_REGISTRAR {
+  public:
+    CHECKPOINT_REGISTRAR(const char *component, const char *name, void *addr, uint64_t size) {
+        CHECKPOINT_REGION region;
+        region.component = component;
+        region.name = name;
+        region.addr = addr;
+        region.size = size;
+
+        checkpoint_regions().push_back(region);
+    };
+};
+
+// registers a global table of a module, e.g. CHECKPOINT_STATE(bimodal_table);
+// only tables without pointers can be registered
+// tables of a component are only saved and restored when the component is selected, see component_impl.h
+#define CHECKPOINT_STATE(var) static CHECKPOINT_REGISTRAR checkpoint_##var("", #var, &(var), sizeof(var))
+
+void save_checkpoint(const char *filename),
+     load_checkpoint(const char *filename);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef COMPONENT_H
+#define COMPONENT_H
+
+#include <set>
+#include <string>
+
+#include "champsim.h"
+
+// branch predictors, prefetchers and LLC replacement policies are all compiled into the binary and
+// selected by name at run time. every component is compiled by a wrapper the Makefile generates in obj/gen/
+// inside a namespace of its own, where its hooks are free functions taking the real O3_CPU or CACHE. the selected
+// component of every kind is bound to an index at startup, and a hook is a switch on that index with a direct call
+// in each case
+class BLOCK;
+class CACHE;
+class O3_CPU;
+
+// every component compiled into the binary, X(namespace of its wrapper, name on the command line, ...), in
+// BRANCH_PREDICTORS, L1D_PREFETCHERS, L2C_PREFETCHERS, LLC_PREFETCHERS and LLC_REPLACEMENTS. generated by the
+// Makefile from branch/*.bpred, prefetcher/*.l1d_pref, *.l2c_pref, *.llc_pref and replacement/*.llc_repl
+#include "component_list.h"
+
+// hooks of every component
+#define DECLARE_BRANCH_PREDICTOR(ns, name, ...) \
+    namespace ns { \
+        void initialize_branch_predictor(O3_CPU &core), \
+             last_branch_result(O3_CPU &core, uint64_t ip, uint8_t taken); \
+        uint8_t predict_branch(O3_CPU &core, uint64_t ip); \
+    }
+
+#define DECLARE_L1D_PREFETCHER(ns, name, ...) \
+    namespace ns { \
+        void l1d_prefetcher_initialize(CACHE &cache), \
+             l1d_prefetcher_operate(CACHE &cache, uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type), \
+             l1d_prefetcher_cache_fill(CACHE &cache, uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in), \
+             l1d_prefetcher_final_stats(CACHE &cache); \
+    }
+
+#define DECLARE_L2C_PREFETCHER(ns, name, ...) \
+    namespace ns { \
+        void l2c_prefetcher_initialize(CACHE &cache), \
+             l2c_prefetcher_final_stats(CACHE &cache); \
+        uint32_t l2c_prefetcher_operate(CACHE &cache, uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in), \
+                 l2c_prefetcher_cache_fill(CACHE &cache, uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in); \
+    }
+
+#define DECLARE_LLC_PREFETCHER(ns, name, ...) \
+    namespace ns { \
+        void llc_prefetcher_initialize(CACHE &cache), \
+             llc_prefetcher_final_stats(CACHE &cache); \
+        uint32_t llc_prefetcher_operate(CACHE &cache, uint64_t addr, uint64_t ip, uint8_t cache_hit, uint8_t type, uint32_t metadata_in), \
+                 llc_prefetcher_cache_fill(CACHE &cache, uint64_t addr, uint32_t set, uint32_t way, uint8_t prefetch, uint64_t evicted_addr, uint32_t metadata_in); \
+    }
+
+#define DECLARE_LLC_REPLACEMENT(ns, name, ...) \
+    namespace ns { \
+        void llc_initialize_replacement(CACHE &cache), \
+             llc_update_replacement_state(CACHE &cache, uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type, uint8_t hit), \
+             llc_replacement_final_stats(CACHE &cache); \
+        uint32_t llc_find_victim(CACHE &cache, uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type); \
+    }
+
+BRANCH_PREDICTORS(DECLARE_BRANCH_PREDICTOR, )
+L1D_PREFETCHERS(DECLARE_L1D_PREFETCHER, )
+L2C_PREFETCHERS(DECLARE_L2C_PREFETCHER, )
+LLC_PREFETCHERS(DECLARE_LLC_PREFETCHER, )
+LLC_REPLACEMENTS(DECLARE_LLC_REPLACEMENT, )
+
+// index of every component within its kind, in list order
+#define COMPONENT_INDEX(ns, name, ...) ns##_index,
+
+enum { BRANCH_PREDICTORS(COMPONENT_INDEX, ) NUM_BRANCH_PREDICTORS };
+enum { L1D_PREFETCHERS(COMPONENT_INDEX, ) NUM_L1D_PREFETCHERS };
+enum { L2C_PREFETCHERS(COMPONENT_INDEX, ) NUM_L2C_PREFETCHERS };
+enum { LLC_PREFETCHERS(COMPONENT_INDEX, ) NUM_LLC_PREFETCHERS };
+enum { LLC_REPLACEMENTS(COMPONENT_INDEX, ) NUM_LLC_REPLACEMENTS };
+
+// calls hook(args) of the selected component of a kind, e.g.
+// CALL_COMPONENT(LLC_REPLACEMENTS, llc_replacement, llc_find_victim(*this, cpu, ...))
+#define COMPONENT_CASE(ns, name, ...) case ns##_index: return ns::__VA_ARGS__;
+#define CALL_COMPONENT(COMPONENTS, selected, ...) switch (selected) { COMPONENTS(COMPONENT_CASE, __VA_ARGS__) }
+
+// the components of this run, set by select_components()
+extern uint32_t branch_predictor,
+                l1d_prefetcher,
+                l2c_prefetcher,
+                llc_prefetcher,
+                llc_replacement;
+
+// "name.kind" of every selected component, e.g. "bimodal.bpred"
+extern set<string> selected_components;
+
+void select_components(const char *bpred, const char *l1d_pref, const char *l2c_pref, const char *llc_pref, const char *llc_repl);
+
+#endif
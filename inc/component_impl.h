@@ -0,0 +1,9 @@
+// included by the component wrappers the Makefile generates in obj/gen/ inside the namespace of their
+// component (see component.h), right before its source. the hooks are free functions of that namespace taking
+// the real O3_CPU or CACHE, so the state and helpers of a component never collide with the other components
+// compiled into the binary.
+// there is no include guard on purpose
+
+// state is saved under "name.kind/variable" and only for the selected components
+#undef CHECKPOINT_STATE
+#define CHECKPOINT_STATE(var) static CHECKPOINT_REGISTRAR checkpoint_##var(COMPONENT_NAME, COMPONENT_NAME "/" #var, &(var), sizeof(var))
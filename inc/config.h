@@ -0,0 +1,12 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "ooo_cpu.h"
+#include "dram_controller.h"
+
+// reads an INI file with [core], [itlb], [dtlb], [stlb], [l1i], [l1d], [l2c], [llc] and [dram] sections
+// of "key = value" lines into core_config, the cache configs and the core and DRAM globals.
+// keys are named like the configuration printed at startup, e.g. "sets", "ways", "mshr_size" or "rob_size"
+void load_config(const char *filename);
+
+#endif
@@ -5,12 +5,11 @@
 
 // DRAM configuration
 #define DRAM_CHANNEL_WIDTH 8 // 8B
-#define DRAM_WQ_SIZE 64
-#define DRAM_RQ_SIZE 64
 
-#define tRP_DRAM_NANOSECONDS  15
-#define tRCD_DRAM_NANOSECONDS 15
-#define tCAS_DRAM_NANOSECONDS 12.5
+// queue sizes and timings are initialized in dram_controller.cc and changed by -config,
+// channels, ranks and banks are in champsim.h
+extern uint32_t DRAM_WQ_SIZE, DRAM_RQ_SIZE;
+extern double tRP_DRAM_NANOSECONDS, tRCD_DRAM_NANOSECONDS, tCAS_DRAM_NANOSECONDS;
 
 // the data bus must wait this amount of time when switching between reads and writes, and vice versa
 #define DRAM_DBUS_TURN_AROUND_TIME ((15*CPU_FREQ)/2000) // 7.5 ns 
@@ -62,12 +61,10 @@ class MEMORY_CONTROLLER : public MEMORY {
             }
 
             WQ[i].NAME = "DRAM_WQ" + to_string(i);
-            WQ[i].SIZE = DRAM_WQ_SIZE;
-            WQ[i].entry = new PACKET [DRAM_WQ_SIZE];
+            WQ[i].resize(DRAM_WQ_SIZE);
 
             RQ[i].NAME = "DRAM_RQ" + to_string(i);
-            RQ[i].SIZE = DRAM_RQ_SIZE;
-            RQ[i].entry = new PACKET [DRAM_RQ_SIZE];
+            RQ[i].resize(DRAM_RQ_SIZE);
         }
 
         fill_level = FILL_DRAM;
@@ -90,6 +87,9 @@ class MEMORY_CONTROLLER : public MEMORY {
     uint32_t get_occupancy(uint8_t queue_type, uint64_t address),
              get_size(uint8_t queue_type, uint64_t address);
 
+    void functional_access(PACKET *packet),
+         configure();
+
     void schedule(PACKET_QUEUE *queue), process(PACKET_QUEUE *queue),
          update_schedule_cycle(PACKET_QUEUE *queue),
          update_process_cycle(PACKET_QUEUE *queue),
@@ -102,7 +102,9 @@ class MEMORY_CONTROLLER : public MEMORY {
              dram_get_column (uint64_t address),
              drc_check_hit (uint64_t address, uint32_t cpu, uint32_t channel, uint32_t rank, uint32_t bank, uint32_t row);
 
-    uint64_t get_bank_earliest_cycle();
+    uint64_t get_bank_earliest_cycle(),
+             get_next_event_cycle(),
+             get_next_queue_event(PACKET_QUEUE *queue, uint64_t cycle);
 
     int check_dram_queue(PACKET_QUEUE *queue, PACKET *packet);
 };
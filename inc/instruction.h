@@ -6,12 +6,31 @@
 #define ROB_SIZE 256
 #define LQ_SIZE 72
 #define SQ_SIZE 56
+// -config can resize them up to these bounds, a rob index has to fit a fastset
+#define MAX_ROB_SIZE 512
+#define MAX_LQ_SIZE 512
+#define MAX_SQ_SIZE 512
 #define NUM_INSTR_DESTINATIONS_SPARC 4
 #define NUM_INSTR_DESTINATIONS 2
 #define NUM_INSTR_SOURCES 4
 
+// register numbers are a byte in the traces
+#define NUM_REGISTERS 256
+
 #include "set.h"
 
+// a ROB entry writing a register or storing to an address, it is still in the ROB if the entry at rob_index holds instr_id
+class ROB_WRITER {
+  public:
+    uint32_t rob_index;
+    uint64_t instr_id;
+
+    ROB_WRITER() {
+        rob_index = UINT32_MAX;
+        instr_id = 0;
+    };
+};
+
 class input_instr {
   public:
 
@@ -83,6 +102,29 @@ class cloudsuite_instr {
     };
 };
 
+// a trace record converted for the front end, its operands are counted once when the record is read
+class decoded_instr {
+  public:
+    uint64_t ip;
+
+    uint8_t is_branch,
+            branch_taken,
+            asid[2],
+            num_reg_ops,
+            num_mem_ops,
+            num_stores;
+
+    uint8_t destination_registers[NUM_INSTR_DESTINATIONS_SPARC],
+            source_registers[NUM_INSTR_SOURCES];
+
+    uint64_t destination_memory[NUM_INSTR_DESTINATIONS_SPARC],
+             source_memory[NUM_INSTR_SOURCES];
+
+    decoded_instr() {
+        memset(this, 0, sizeof(decoded_instr));
+    };
+};
+
 class ooo_model_instr {
   public:
     uint64_t instr_id,
@@ -128,6 +170,12 @@ class ooo_model_instr {
     fastset
 	registers_instrs_depend_on_me, registers_index_depend_on_me[NUM_INSTR_SOURCES];
 
+    // the last writers of the source registers and the previous writers of the destination registers
+    // when this instruction entered the ROB, they chain the writers of each register together
+    ROB_WRITER source_writer[NUM_INSTR_SOURCES], prior_writer[NUM_INSTR_DESTINATIONS_SPARC];
+
+    // the youngest older store to each load address when this instruction entered the ROB
+    ROB_WRITER source_store[NUM_INSTR_SOURCES];
 
     // memory addresses that may cause dependencies between instructions
     uint64_t instruction_pa, data_pa, virtual_address, physical_address;
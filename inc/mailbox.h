@@ -0,0 +1,62 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <deque>
+
+#include "memory_class.h"
+
+// request sent by a core that runs ahead of the shared lower level
+class MAILBOX_ENTRY {
+  public:
+    uint64_t cycle;
+    uint8_t  queue_type; // 1: RQ, 2: WQ, 3: PQ (same as get_occupancy), 0: the request found the WQ full
+    PACKET   packet;
+};
+
+// stands in for the shared LLC below the L2C of one core in -sync_quantum mode.
+// requests are stamped with the core cycle they were sent at and handed over to the LLC
+// in cycle order while the uncore catches up at the end of the quantum
+class MAILBOX : public MEMORY {
+  public:
+    uint32_t cpu;
+    MEMORY *shared_level;
+    std::deque<MAILBOX_ENTRY> pending;
+
+    // queue occupancy of the shared level seen by this core during the quantum
+    uint32_t occupancy[4];
+
+    MAILBOX() {
+        cpu = 0;
+        shared_level = NULL;
+        lower_level = NULL;
+        extra_interface = NULL;
+
+        for (uint32_t i=0; i<NUM_CPUS; i++) {
+            upper_level_icache[i] = NULL;
+            upper_level_dcache[i] = NULL;
+        }
+
+        for (uint32_t i=0; i<4; i++)
+            occupancy[i] = 0;
+    };
+
+    // functions
+    int  add_rq(PACKET *packet),
+         add_wq(PACKET *packet),
+         add_pq(PACKET *packet);
+
+    void return_data(PACKET *packet),
+         operate(),
+         increment_WQ_FULL(uint64_t address);
+
+    uint32_t get_occupancy(uint8_t queue_type, uint64_t address),
+             get_size(uint8_t queue_type, uint64_t address);
+
+    void functional_access(PACKET *packet);
+
+    void begin_quantum(),
+         add_request(uint8_t queue_type, PACKET *packet),
+         deliver(uint64_t cycle);
+};
+
+#endif
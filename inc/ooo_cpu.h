@@ -3,6 +3,7 @@
 
 #include "cache.h"
 #include "instruction.h"
+#include "trace_reader.h"
 
 #ifdef CRC2_COMPILE
 #define STAT_PRINTING_PERIOD 1000000
@@ -14,21 +15,27 @@
 using namespace std;
 
 // CORE PROCESSOR
-#define FETCH_WIDTH 6
-#define DECODE_WIDTH 6
-#define EXEC_WIDTH 4
-#define LQ_WIDTH 2
-#define SQ_WIDTH 2
-#define RETIRE_WIDTH 4
-#define SCHEDULER_SIZE 128
-#define BRANCH_MISPREDICT_PENALTY 20
+// initialized in ooo_cpu.cc and changed by -config
+extern uint32_t FETCH_WIDTH, DECODE_WIDTH, EXEC_WIDTH, LQ_WIDTH, SQ_WIDTH, RETIRE_WIDTH,
+                SCHEDULER_SIZE, BRANCH_MISPREDICT_PENALTY;
 //#define SCHEDULING_LATENCY 6
 //#define EXEC_LATENCY 1
 
-#define STA_SIZE (ROB_SIZE*NUM_INSTR_DESTINATIONS_SPARC)
+#define MAX_STA_SIZE (MAX_ROB_SIZE*NUM_INSTR_DESTINATIONS_SPARC)
+
+// trace records are read and decoded this many at a time
+#define DECODE_BUFFER_SIZE 64
 
 extern uint32_t SCHEDULING_LATENCY, EXEC_LATENCY;
 
+// the sizes of the core buffers, initialized with ROB_SIZE, LQ_SIZE and SQ_SIZE and changed by -config
+class CORE_CONFIG {
+  public:
+    uint32_t rob_size, lq_size, sq_size;
+};
+
+extern CORE_CONFIG core_config;
+
 void print_core_config();
 
 // cpu
@@ -37,13 +44,18 @@ class O3_CPU {
     uint32_t cpu;
 
     // trace
-    FILE *trace_file;
+    TRACE_READER trace_reader;
     char trace_string[1024];
-    char gunzip_command[1024];
+
+    // decoded instructions not yet taken by the front end
+    decoded_instr decode_buffer[DECODE_BUFFER_SIZE];
+    uint32_t decode_head, decode_tail;
+
+    // with the parallel engines, messages are held here and printed in core order
+    uint8_t defer_output;
+    ostringstream deferred_output;
 
     // instruction
-    input_instr current_instr;
-    cloudsuite_instr current_cloudsuite_instr;
     uint64_t instr_unique_id, completed_executions, 
              begin_sim_cycle, begin_sim_instr, 
              last_sim_cycle, last_sim_instr,
@@ -58,19 +70,34 @@ class O3_CPU {
     LOAD_STORE_QUEUE LQ{"LQ", LQ_SIZE}, SQ{"SQ", SQ_SIZE};
     
     // store array, this structure is required to properly handle store instructions
-    uint64_t STA[STA_SIZE], STA_head, STA_tail; 
+    // the arrays are allocated for the largest configuration, only the first STA_SIZE, ROB.SIZE, LQ.SIZE and SQ.SIZE entries are used
+    uint64_t STA[MAX_STA_SIZE], STA_head, STA_tail; 
+    uint32_t STA_SIZE;
+
+    // rename table, the youngest instruction in the ROB writing each register
+    ROB_WRITER last_writer[NUM_REGISTERS];
+
+    // the youngest store in the ROB to each address, and the free load queue entries
+    STORE_INDEX store_index;
+    INDEX_SET lq_free;
 
     // Ready-To-Execute
-    uint32_t RTE0[ROB_SIZE], RTE0_head, RTE0_tail, 
-             RTE1[ROB_SIZE], RTE1_head, RTE1_tail;  
+    uint32_t RTE0[MAX_ROB_SIZE], RTE0_head, RTE0_tail, 
+             RTE1[MAX_ROB_SIZE], RTE1_head, RTE1_tail;  
+
+    // wakeup and select: the executing instructions that can complete, the memory instructions whose
+    // producers are done, and the event cycles of all ROB entries and of the memory ones, which tell
+    // where the in-order scheduling scans stop without walking the ROB up to there
+    INDEX_SET completing, memory_ready;
+    ROB_CYCLE_TREE rob_event, memory_event;
 
     // Ready-To-Load
-    uint32_t RTL0[LQ_SIZE], RTL0_head, RTL0_tail, 
-             RTL1[LQ_SIZE], RTL1_head, RTL1_tail;  
+    uint32_t RTL0[MAX_LQ_SIZE], RTL0_head, RTL0_tail, 
+             RTL1[MAX_LQ_SIZE], RTL1_head, RTL1_tail;  
 
     // Ready-To-Store
-    uint32_t RTS0[SQ_SIZE], RTS0_head, RTS0_tail,
-             RTS1[SQ_SIZE], RTS1_head, RTS1_tail;
+    uint32_t RTS0[MAX_SQ_SIZE], RTS0_head, RTS0_tail,
+             RTS1[MAX_SQ_SIZE], RTS1_head, RTS1_tail;
 
     // branch
     int branch_mispredict_stall_fetch; // flag that says that we should stall because a branch prediction was wrong
@@ -93,7 +120,9 @@ class O3_CPU {
         cpu = 0;
 
         // trace
-        trace_file = NULL;
+        defer_output = 0;
+        decode_head = 0;
+        decode_tail = 0;
 
         // instruction
         instr_unique_id = 0;
@@ -126,32 +155,48 @@ class O3_CPU {
         num_branch = 0;
         branch_mispredictions = 0;
 
+        reset_ready_queues();
+    }
+
+    // the queues of ready instructions, with the sizes of ROB, LQ and SQ as their empty marks
+    void reset_ready_queues() {
+        STA_SIZE = ROB.SIZE*NUM_INSTR_DESTINATIONS_SPARC;
         for (uint32_t i=0; i<STA_SIZE; i++)
             STA[i] = UINT64_MAX;
         STA_head = 0;
         STA_tail = 0;
 
-        for (uint32_t i=0; i<ROB_SIZE; i++) {
-            RTE0[i] = ROB_SIZE;
-            RTE1[i] = ROB_SIZE;
+        for (uint32_t i=0; i<ROB.SIZE; i++) {
+            RTE0[i] = ROB.SIZE;
+            RTE1[i] = ROB.SIZE;
         }
         RTE0_head = 0;
         RTE1_head = 0;
         RTE0_tail = 0;
         RTE1_tail = 0;
 
-        for (uint32_t i=0; i<LQ_SIZE; i++) {
-            RTL0[i] = LQ_SIZE;
-            RTL1[i] = LQ_SIZE;
+        completing.clear();
+        memory_ready.clear();
+        rob_event.clear();
+        memory_event.clear();
+
+        for (uint32_t i=0; i<LQ.SIZE; i++) {
+            RTL0[i] = LQ.SIZE;
+            RTL1[i] = LQ.SIZE;
         }
         RTL0_head = 0;
         RTL1_head = 0;
         RTL0_tail = 0;
         RTL1_tail = 0;
 
-        for (uint32_t i=0; i<SQ_SIZE; i++) {
-            RTS0[i] = SQ_SIZE;
-            RTS1[i] = SQ_SIZE;
+        lq_free.clear();
+        for (uint32_t i=0; i<LQ.SIZE; i++)
+            lq_free.insert(i);
+        store_index.clear();
+
+        for (uint32_t i=0; i<SQ.SIZE; i++) {
+            RTS0[i] = SQ.SIZE;
+            RTS1[i] = SQ.SIZE;
         }
         RTS0_head = 0;
         RTS1_head = 0;
@@ -161,6 +206,10 @@ class O3_CPU {
 
     // functions
     void handle_branch(),
+         reopen_trace(),
+         fast_forward_instruction(),
+         skip_trace(uint64_t num_instrs),
+         functional_data_access(uint64_t va, uint64_t ip, uint8_t asid, uint8_t type),
          fetch_instruction(),
          schedule_instruction(),
          execute_instruction(),
@@ -180,23 +229,42 @@ class O3_CPU {
          handle_merged_load(PACKET *provider),
          release_load_queue(uint32_t lq_index),
          complete_instr_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb),
-         complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb);
+         complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb),
+         set_event_cycle(uint32_t rob_index, uint64_t cycle),
+         wake_completion(uint32_t rob_index);
 
-    void initialize_core();
+    void initialize_core(),
+         configure(const CORE_CONFIG &config);
     void add_load_queue(uint32_t rob_index, uint32_t data_index),
          add_store_queue(uint32_t rob_index, uint32_t data_index),
          execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_index);
     int  execute_load(uint32_t rob_index, uint32_t sq_index, uint32_t data_index);
     void check_dependency(int prior, int current);
+    uint8_t in_rob(const ROB_WRITER &writer);
     void operate_cache();
     void update_rob();
     void retire_rob();
 
-    uint32_t  add_to_rob(ooo_model_instr *arch_instr),
-              check_rob(uint64_t instr_id);
+    const decoded_instr *next_instr();
+
+    uint32_t  fill_decode_buffer(),
+              add_to_rob(const decoded_instr *instr),
+              check_rob(uint64_t instr_id),
+              find_reg_producer(ROB_WRITER *link, uint8_t reg);
 
     uint32_t check_and_add_lsq(uint32_t rob_index);
 
+    uint32_t scheduled_window(),
+             find_in_window(INDEX_SET &set, uint32_t begin, uint32_t end),
+             find_later_in_window(ROB_CYCLE_TREE &tree, uint32_t begin, uint32_t end, uint64_t cycle);
+
+    uint64_t functional_translate(CACHE *tlb, uint64_t va, uint64_t vpage, uint8_t type);
+
+    // event skipping
+    uint64_t get_next_event_cycle(),
+             get_next_schedule_event(uint64_t cycle),
+             get_next_memory_schedule_event(uint64_t cycle);
+
     // branch predictor
     uint8_t predict_branch(uint64_t ip);
     void    initialize_branch_predictor(),
@@ -205,4 +273,9 @@ class O3_CPU {
 
 extern O3_CPU ooo_cpu[NUM_CPUS];
 
+// branch predictor hooks go to the component selected at run time
+inline void O3_CPU::initialize_branch_predictor() { CALL_COMPONENT(BRANCH_PREDICTORS, branch_predictor, initialize_branch_predictor(*this)); }
+inline uint8_t O3_CPU::predict_branch(uint64_t ip) { CALL_COMPONENT(BRANCH_PREDICTORS, branch_predictor, predict_branch(*this, ip)); return 0; }
+inline void O3_CPU::last_branch_result(uint64_t ip, uint8_t taken) { CALL_COMPONENT(BRANCH_PREDICTORS, branch_predictor, last_branch_result(*this, ip, taken)); }
+
 #endif
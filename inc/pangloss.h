@@ -4,6 +4,7 @@
 
 #include <stdint.h>
 
+// included inside the namespace of both pangloss wrappers, each using only part of it, so nothing here is static
 
 #define WORD_SIZE_OFFSET 2
 #define PAGE_SIZE_OFFSET 12
@@ -24,7 +25,7 @@ struct L1DDeltaCacheEntry {
     int LFU_count; 
 };
 // l1d Delta Cache
-static L1DDeltaCacheEntry L1D_Delta_Cache[L1D_DELTA_CACHE_SETS][L1D_DELTA_CACHE_WAYS];
+L1DDeltaCacheEntry L1D_Delta_Cache[L1D_DELTA_CACHE_SETS][L1D_DELTA_CACHE_WAYS];
 
 // l1d Page Cache 相关数据
 // l1d Page Cache 大小为 256 sets * 12 ways
@@ -40,12 +41,12 @@ struct L1DPageCacheEntry {
     int NRU_bit; 
 };
 // l1d Page Cache
-static L1DPageCacheEntry L1D_Page_Cache[L1D_PAGE_CACHE_SETS][L1D_PAGE_CACHE_WAYS];
+L1DPageCacheEntry L1D_Page_Cache[L1D_PAGE_CACHE_SETS][L1D_PAGE_CACHE_WAYS];
 
 /*
 * 根据给定的page 返回 page tag
 */
-static int get_l1d_page_tag(uint64_t page) {
+inline int get_l1d_page_tag(uint64_t page) {
     // 取高位
     uint64_t high_bits = page / L1D_PAGE_CACHE_SETS;
     // 取高位中的低10位
@@ -57,7 +58,7 @@ static int get_l1d_page_tag(uint64_t page) {
 * 更新 l1d cache
 * 增加了一个 delta transition (delta_from -> delta_to)
 */
-static void update_l1d_delta_cache(int delta_from, int delta_to) {
+inline void update_l1d_delta_cache(int delta_from, int delta_to) {
 	// 首先检查 delta_to 是否在 Delta Cache 中命中、
 	// 此时同时检查 LFU 最小的 way
 	int lfu_way = 0;
@@ -89,7 +90,7 @@ static void update_l1d_delta_cache(int delta_from, int delta_to) {
 /*
 * 根据当前的 delta 确定下一次最可能选择的 next_delta
 */
-static int get_l1d_next_best_transition (int delta) {
+inline int get_l1d_next_best_transition (int delta) {
 	// 计算在当前 set 中 LFU_count 的总和 进而计算概率
 	// 并且找到最大的 LFU 值和对应的 way
 	int set_LFU_sum = 0;
@@ -124,7 +125,7 @@ struct L2CDeltaCacheEntry {
     int LFU_count; 
 };
 // l2c Delta Cache
-static L2CDeltaCacheEntry L2C_Delta_Cache[L2C_DELTA_CACHE_SETS][L2C_DELTA_CACHE_WAYS];
+L2CDeltaCacheEntry L2C_Delta_Cache[L2C_DELTA_CACHE_SETS][L2C_DELTA_CACHE_WAYS];
 
 // l2c Page Cache 相关数据
 // l2c Page Cache 大小为 256 sets * 12 ways
@@ -140,12 +141,12 @@ struct L2CPageCacheEntry {
     int NRU_bit; 
 };
 // l2c Page Cache
-static L2CPageCacheEntry L2C_Page_Cache[L2C_PAGE_CACHE_SETS][L2C_PAGE_CACHE_WAYS];
+L2CPageCacheEntry L2C_Page_Cache[L2C_PAGE_CACHE_SETS][L2C_PAGE_CACHE_WAYS];
 
 /*
 * 根据给定的page 返回 page tag
 */
-static int get_l2c_page_tag(uint64_t page) {
+inline int get_l2c_page_tag(uint64_t page) {
     // 取高位
     uint64_t high_bits = page / L2C_PAGE_CACHE_SETS;
     // 取高位中的低10位
@@ -157,7 +158,7 @@ static int get_l2c_page_tag(uint64_t page) {
 * 更新 l2c cache
 * 增加了一个 delta transition (delta_from -> delta_to)
 */
-static void update_l2c_delta_cache(int delta_from, int delta_to) {
+inline void update_l2c_delta_cache(int delta_from, int delta_to) {
 	// 首先检查 delta_to 是否在 Delta Cache 中命中、
 	// 此时同时检查 LFU 最小的 way
 	int lfu_way = 0;
@@ -189,7 +190,7 @@ static void update_l2c_delta_cache(int delta_from, int delta_to) {
 /*
 * 根据当前的 delta 确定下一次最可能选择的 next_delta
 */
-static int get_l2c_next_best_transition (int delta) {
+inline int get_l2c_next_best_transition (int delta) {
 	// 计算在当前 set 中 LFU_count 的总和 进而计算概率
 	// 并且找到最大的 LFU 值和对应的 way
 	int set_LFU_sum = 0;
@@ -0,0 +1,53 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "champsim.h"
+
+// waiting threads spin this many times before yielding the host cpu
+#define BARRIER_SPIN_LIMIT 1024
+
+// phases handed to the worker threads
+#define PARALLEL_EXIT UINT32_MAX
+
+// reusable barrier for a fixed number of threads
+class SPIN_BARRIER {
+  public:
+    uint32_t num_threads;
+    std::atomic<uint32_t> count, generation;
+
+    SPIN_BARRIER() {
+        num_threads = 1;
+        count = 0;
+        generation = 0;
+    };
+
+    void wait();
+};
+
+// runs a per-core function on a fixed pool of host threads
+// core i is always simulated by thread (i % num_threads), thread 0 being the caller of run()
+class PARALLEL_ENGINE {
+  public:
+    uint32_t num_threads, phase;
+    void (*core_work)(uint32_t cpu, uint32_t phase);
+    SPIN_BARRIER barrier;
+    std::vector<std::thread> workers;
+
+    PARALLEL_ENGINE() {
+        num_threads = 1;
+        phase = 0;
+        core_work = NULL;
+    };
+
+    void start(uint32_t threads, void (*work)(uint32_t cpu, uint32_t phase)),
+         run(uint32_t run_phase),
+         stop(),
+         worker_loop(uint32_t thread_id),
+         run_cores(uint32_t thread_id);
+};
+
+#endif
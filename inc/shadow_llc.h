@@ -0,0 +1,82 @@
+#ifndef SHADOW_LLC_H
+#define SHADOW_LLC_H
+
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "cache.h"
+
+// tag array of the LLC geometry, driven by another replacement policy on the access stream of the real LLC.
+// blocks are filled as soon as they miss, so it only models hits and misses, not timing
+class SHADOW_LLC {
+  public:
+    const string NAME;
+    const uint32_t NUM_SET, NUM_WAY;
+    uint32_t cpu;
+    BLOCK **block;
+
+    uint64_t sim_access[NUM_CPUS][NUM_TYPES],
+             sim_hit[NUM_CPUS][NUM_TYPES],
+             sim_miss[NUM_CPUS][NUM_TYPES],
+             roi_access[NUM_CPUS][NUM_TYPES],
+             roi_hit[NUM_CPUS][NUM_TYPES],
+             roi_miss[NUM_CPUS][NUM_TYPES];
+
+    SHADOW_LLC(string v1) : NAME(v1), NUM_SET(LLC_SET), NUM_WAY(LLC_WAY) {
+        cpu = 0;
+
+        block = new BLOCK* [NUM_SET];
+        for (uint32_t i=0; i<NUM_SET; i++) {
+            block[i] = new BLOCK[NUM_WAY];
+
+            for (uint32_t j=0; j<NUM_WAY; j++)
+                block[i][j].lru = j;
+        }
+
+        for (uint32_t i=0; i<NUM_CPUS; i++) {
+            for (uint32_t j=0; j<NUM_TYPES; j++) {
+                sim_access[i][j] = 0;
+                sim_hit[i][j] = 0;
+                sim_miss[i][j] = 0;
+                roi_access[i][j] = 0;
+                roi_hit[i][j] = 0;
+                roi_miss[i][j] = 0;
+            }
+        }
+    };
+
+    virtual ~SHADOW_LLC() {
+        for (uint32_t i=0; i<NUM_SET; i++)
+            delete[] block[i];
+        delete[] block;
+    };
+
+    // implemented by the replacement policy
+    virtual void initialize_replacement() = 0;
+    virtual uint32_t find_victim_way(uint32_t cpu, uint64_t instr_id, uint32_t set, uint64_t ip, uint64_t full_addr, uint32_t type) = 0;
+    virtual void update_replacement(uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type, uint8_t hit) = 0;
+
+    void access(PACKET *packet),
+         reset_stats(uint32_t cpu),
+         record_roi_stats(uint32_t cpu);
+};
+
+// shadow policies are selected by name with -llc_shadow
+typedef SHADOW_LLC *(*SHADOW_LLC_FACTORY)();
+
+map<string, SHADOW_LLC_FACTORY> &shadow_llc_policies();
+
+class SHADOW_LLC_REGISTRAR {
+  public:
+    SHADOW_LLC_REGISTRAR(const char *name, SHADOW_LLC_FACTORY factory) {
+        shadow_llc_policies()[name] = factory;
+    };
+};
+
+extern vector<SHADOW_LLC *> shadow_llcs;
+
+void add_shadow_llcs(const char *names),
+     shadow_llc_access(PACKET *packet);
+
+#endif
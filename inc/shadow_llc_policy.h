@@ -0,0 +1,44 @@
+// included by the shadow policy wrappers the Makefile generates in obj/gen/replacement/shadow/ inside a
+// namespace of their own, right before a *.llc_repl file and base_replacement.cc, so that every policy gets its
+// own CACHE class, state and tag array. the hooks of the policy then take this CACHE instead of the real one
+// there is no include guard on purpose
+
+// shadow policies are not part of checkpoints
+#undef CHECKPOINT_STATE
+#define CHECKPOINT_STATE(var)
+
+class CACHE;
+
+// hooks of the policy
+void llc_initialize_replacement(CACHE &cache),
+     llc_update_replacement_state(CACHE &cache, uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type, uint8_t hit),
+     llc_replacement_final_stats(CACHE &cache);
+uint32_t llc_find_victim(CACHE &cache, uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type);
+
+class CACHE : public SHADOW_LLC {
+  public:
+    CACHE(string v1) : SHADOW_LLC(v1) {};
+
+    uint32_t find_victim(uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type),
+             lru_victim(uint32_t cpu, uint64_t instr_id, uint32_t set, const BLOCK *current_set, uint64_t ip, uint64_t full_addr, uint32_t type);
+
+    void update_replacement_state(uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type, uint8_t hit),
+         lru_update(uint32_t set, uint32_t way),
+         replacement_final_stats();
+
+    void initialize_replacement() {
+        llc_initialize_replacement(*this);
+    };
+
+    uint32_t find_victim_way(uint32_t cpu, uint64_t instr_id, uint32_t set, uint64_t ip, uint64_t full_addr, uint32_t type) {
+        return llc_find_victim(*this, cpu, instr_id, set, block[set], ip, full_addr, type);
+    };
+
+    void update_replacement(uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type, uint8_t hit) {
+        llc_update_replacement_state(*this, cpu, set, way, full_addr, ip, victim_addr, type, hit);
+    };
+};
+
+#define SHADOW_LLC_POLICY(name) \
+    static SHADOW_LLC *create_shadow_llc() { return new CACHE(name); } \
+    static SHADOW_LLC_REGISTRAR shadow_llc_registrar(name, create_shadow_llc)
@@ -0,0 +1,40 @@
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+#include <vector>
+
+#include "cache.h"
+
+// one simulation region, start is the index of its first instruction in the trace
+class SIMPOINT {
+  public:
+    uint64_t start,
+             length;
+    double weight;
+};
+
+// weighted sums of the ROI statistics of one cache over all simulated regions
+class SIMPOINT_CACHE_STATS {
+  public:
+    double access[NUM_TYPES],
+           hit[NUM_TYPES],
+           miss[NUM_TYPES],
+           miss_latency;
+
+    SIMPOINT_CACHE_STATS() {
+        for (uint32_t i=0; i<NUM_TYPES; i++) {
+            access[i] = 0;
+            hit[i] = 0;
+            miss[i] = 0;
+        }
+        miss_latency = 0;
+    };
+
+    void add(uint32_t cpu, CACHE *cache, double weight),
+         apply(uint32_t cpu, CACHE *cache);
+};
+
+// reads "start length weight" lines, sorted by start with the weights normalized to 1
+vector<SIMPOINT> read_simpoints(const char *filename);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <stdint.h>
+
+// chunked trace (.ctrace), written by champsim_trace_convert:
+//   CTRACE_HEADER
+//   num_blocks blocks of records_per_block records each (the last one may be shorter)
+//   num_blocks CTRACE_BLOCK entries at index_offset
+// every block decodes on its own, so any instruction is reached by decoding a single block
+#define CTRACE_MAGIC "CHMPCTR1"
+#define CTRACE_RECORDS_PER_BLOCK 16384
+
+// how the records of a block are laid out
+#define CTRACE_ENCODING_RAW   0 // the records as the tracer wrote them
+#define CTRACE_ENCODING_DELTA 1 // IP and address deltas as varints, see encode_delta_block()
+
+// how a block is stored after encoding
+#define CTRACE_COMPRESSION_XZ   0 // an xz stream
+#define CTRACE_COMPRESSION_NONE 1 // as is, raw blocks stored this way are mapped by the simulator
+
+class CTRACE_HEADER {
+  public:
+    char magic[8];
+    uint32_t record_size,
+             records_per_block,
+             encoding,
+             compression;
+    uint64_t num_records,
+             num_blocks,
+             index_offset;
+};
+
+class CTRACE_BLOCK {
+  public:
+    uint64_t offset,
+             size;
+};
+
+// largest delta encoding of a block of the given records
+uint64_t delta_block_bound(uint64_t records, uint32_t record_size);
+
+// encodes records of input_instr or cloudsuite_instr size, returns the encoded size
+uint64_t encode_delta_block(const uint8_t *records, uint64_t num_records, uint32_t record_size, uint8_t *out);
+
+// expands an encoded block back into records, returns 0 if it is malformed
+int decode_delta_block(const uint8_t *in, uint64_t size, uint64_t num_records, uint32_t record_size, uint8_t *records);
+
+#endif
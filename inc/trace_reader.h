@@ -0,0 +1,223 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <lzma.h>
+#include <zlib.h>
+
+#include "champsim.h"
+#include "trace_format.h"
+
+// decoded records buffered ahead of the core, per trace
+#define TRACE_RING_RECORDS 16384
+
+// compressed input is read and decoded output is published in chunks of this size
+#define TRACE_CHUNK_SIZE (1<<16)
+
+// the reader thread sleeps while less than this fraction of the ring is free
+#define TRACE_REFILL_FRACTION 4
+
+// trace formats, told apart by their first bytes
+#define TRACE_GZ      0
+#define TRACE_XZ      1
+#define TRACE_CHUNKED 2
+#define TRACE_PLAIN   3 // uncompressed records
+
+// decoded copies in the trace cache start with a shared header page, the records follow
+#define TRACE_CACHE_MAGIC "CHMPDEC1"
+#define TRACE_CACHE_HEADER_SIZE 4096
+
+// the writer of a decoded copy stays this many records ahead of the furthest reader
+#define TRACE_CACHE_AHEAD (1<<20)
+
+// address space reserved for the records of a decoded copy, which grows while it is mapped
+#define TRACE_CACHE_RESERVE (1ULL<<41)
+
+// shared by the writer and the readers of a decoded copy through their mappings of its first page
+struct TRACE_CACHE_HEADER {
+    char magic[8];
+    uint32_t record_size;
+    std::atomic<uint8_t> complete; // the whole trace has been decoded
+    std::atomic<uint64_t> decoded, // bytes of records published so far
+                          wanted;  // bytes of records the readers asked for
+};
+
+// decompresses a gzip, xz or chunked trace with zlib or liblzma on a host thread of its own.
+// the thread fills a single-producer single-consumer ring of decoded bytes and the core
+// reads its records in place out of it, so no process, pipe or decoder is on the simulation thread.
+// uncompressed traces, and chunked ones stored raw without compression, are mapped instead:
+// records are read straight from the page cache and repeating the trace only resets a pointer.
+// with a cache directory, a compressed trace is decoded once into it, as far as the runs read it, and
+// every process running the trace maps that decoded copy while it grows, see open_cached()
+class TRACE_READER {
+  public:
+    string name;
+    uint32_t record_size;
+    uint8_t format;
+
+    // decoder, only used by the reader thread
+    gzFile gz_file;
+    FILE *xz_file;
+    lzma_stream xz_stream;
+    uint8_t *xz_input, xz_finished;
+
+    // chunked traces, the file and its index stay open across rewinds
+    FILE *chunked_file;
+    CTRACE_HEADER header;
+    std::vector<CTRACE_BLOCK> index;
+    uint8_t *block_data, *encoded_data;
+    uint64_t next_block, block_bytes, block_position;
+
+    // record the current pass started at, only chunked traces start anywhere else than 0
+    uint64_t first_record;
+
+    // records in the trace, only known for chunked and mapped traces
+    uint64_t num_records;
+
+    // mapped traces, the records lie between map_begin and map_end
+    uint8_t mapped;
+    uint8_t *map_data;
+    uint64_t map_size;
+    const uint8_t *map_begin, *map_end, *map_position;
+
+    // decoded copy in the trace cache, mapped while it grows. the process holding the flock on cache_fd
+    // runs the writer thread, which decodes the trace into the copy
+    uint8_t growing;
+    int cache_fd;
+    TRACE_CACHE_HEADER *cache_header;
+    std::thread cache_writer;
+    std::atomic<uint8_t> cache_stop;
+
+    // the ring size is a multiple of record_size, records start at multiples of it and never wrap around
+    uint8_t *ring;
+    uint64_t ring_size;
+
+    // byte counters since the current pass started, written by one side each and on separate cache lines
+    alignas(64) std::atomic<uint64_t> written;
+    alignas(64) std::atomic<uint64_t> consumed;
+    std::atomic<uint8_t> finished, stop;
+
+    // the core's copies
+    alignas(64) uint64_t available, position;
+
+    std::thread reader;
+
+    TRACE_READER() {
+        record_size = 0;
+        format = TRACE_GZ;
+        gz_file = NULL;
+        xz_file = NULL;
+        xz_input = NULL;
+        xz_finished = 0;
+        chunked_file = NULL;
+        block_data = NULL;
+        encoded_data = NULL;
+        next_block = 0;
+        block_bytes = 0;
+        block_position = 0;
+        first_record = 0;
+        num_records = 0;
+        mapped = 0;
+        map_data = NULL;
+        map_size = 0;
+        map_begin = NULL;
+        map_end = NULL;
+        map_position = NULL;
+        growing = 0;
+        cache_fd = -1;
+        cache_header = NULL;
+        cache_stop = 0;
+        ring = NULL;
+        ring_size = 0;
+        written = 0;
+        consumed = 0;
+        finished = 0;
+        stop = 0;
+        available = 0;
+        position = 0;
+    };
+
+    ~TRACE_READER() {
+        close();
+        close_cached();
+        if (chunked_file)
+            fclose(chunked_file);
+        delete[] ring;
+        delete[] xz_input;
+        delete[] block_data;
+        delete[] encoded_data;
+        unmap();
+    };
+
+    // returns the next record in place, it stays valid until the following call. NULL at the end of the trace
+    const uint8_t *next() {
+        if (mapped) {
+            if ((map_position == map_end) && !follow_writer())
+                return NULL;
+            const uint8_t *record = map_position;
+            map_position += record_size;
+            return record;
+        }
+
+        // only now the previous record is handed back to the reader thread
+        consumed.store(position, std::memory_order_release);
+
+        if (available - position < record_size) {
+            if (!wait_for_data())
+                return NULL;
+        }
+
+        const uint8_t *record = ring + (position % ring_size);
+        position += record_size;
+
+        return record;
+    };
+
+    // copies the next record, returns 0 at the end of the trace
+    int read(void *record) {
+        const uint8_t *source = next();
+        if (source == NULL)
+            return 0;
+
+        memcpy(record, source, record_size);
+        return 1;
+    };
+
+    // index of the next record in the trace
+    uint64_t current_record() {
+        if (mapped)
+            return (map_position - map_begin) / record_size;
+        return first_record + (position / record_size);
+    };
+
+    // only chunked and mapped traces know their length and can seek, a decoded copy once it is complete
+    uint8_t seekable() {
+        return (format == TRACE_CHUNKED) || (mapped && !growing);
+    };
+
+    void open(const char *filename, uint32_t size, const char *cache_dir),
+         rewind(),
+         seek(uint64_t record),
+         close(),
+         start(uint64_t record),
+         reader_loop(),
+         open_chunked(),
+         map(const char *filename, uint64_t offset, uint64_t records),
+         unmap(),
+         open_decoder(uint64_t record),
+         close_decoder(),
+         read_block(uint64_t block),
+         cache_writer_loop(),
+         close_cached();
+
+    int wait_for_data(),
+        open_cached(const char *cache_dir),
+        follow_writer();
+
+    uint64_t decode(uint8_t *out, uint64_t size),
+             decode_chunked(uint8_t *out, uint64_t size);
+};
+
+#endif
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace bimodal_bpred {
+
+#define COMPONENT_NAME "bimodal.bpred"
+#include "component_impl.h"
+#include "branch/bimodal.bpred"
+
+}
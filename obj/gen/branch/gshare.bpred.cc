@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace gshare_bpred {
+
+#define COMPONENT_NAME "gshare.bpred"
+#include "component_impl.h"
+#include "branch/gshare.bpred"
+
+}
@@ -0,0 +1,14 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace hashed_perceptron_bpred {
+
+#define COMPONENT_NAME "hashed_perceptron.bpred"
+#include "component_impl.h"
+#include "branch/hashed_perceptron.bpred"
+
+}
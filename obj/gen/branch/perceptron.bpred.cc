@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace perceptron_bpred {
+
+#define COMPONENT_NAME "perceptron.bpred"
+#include "component_impl.h"
+#include "branch/perceptron.bpred"
+
+}
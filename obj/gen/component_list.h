@@ -0,0 +1,34 @@
+#define BRANCH_PREDICTORS(X, ...) \
+    X(bimodal_bpred, "bimodal", __VA_ARGS__) \
+    X(gshare_bpred, "gshare", __VA_ARGS__) \
+    X(hashed_perceptron_bpred, "hashed_perceptron", __VA_ARGS__) \
+    X(perceptron_bpred, "perceptron", __VA_ARGS__) \
+
+#define L1D_PREFETCHERS(X, ...) \
+    X(next_line_l1d_pref, "next_line", __VA_ARGS__) \
+    X(no_l1d_pref, "no", __VA_ARGS__) \
+    X(pangloss_l1d_pref, "pangloss", __VA_ARGS__) \
+
+#define L2C_PREFETCHERS(X, ...) \
+    X(GHB_l2c_pref, "GHB", __VA_ARGS__) \
+    X(ip_stride_l2c_pref, "ip_stride", __VA_ARGS__) \
+    X(next_line_l2c_pref, "next_line", __VA_ARGS__) \
+    X(no_l2c_pref, "no", __VA_ARGS__) \
+    X(pangloss_l2c_pref, "pangloss", __VA_ARGS__) \
+
+#define LLC_PREFETCHERS(X, ...) \
+    X(ip_stride_llc_pref, "ip_stride", __VA_ARGS__) \
+    X(next_line_llc_pref, "next_line", __VA_ARGS__) \
+    X(no_llc_pref, "no", __VA_ARGS__) \
+
+#define LLC_REPLACEMENTS(X, ...) \
+    X(LFU_llc_repl, "LFU", __VA_ARGS__) \
+    X(drrip_llc_repl, "drrip", __VA_ARGS__) \
+    X(lru_llc_repl, "lru", __VA_ARGS__) \
+    X(red_llc_repl, "red", __VA_ARGS__) \
+    X(red_lfu_llc_repl, "red_lfu", __VA_ARGS__) \
+    X(ship_llc_repl, "ship", __VA_ARGS__) \
+    X(shippp_red_llc_repl, "shippp+red", __VA_ARGS__) \
+    X(shippp_llc_repl, "shippp", __VA_ARGS__) \
+    X(srrip_llc_repl, "srrip", __VA_ARGS__) \
+
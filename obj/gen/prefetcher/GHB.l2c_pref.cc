@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace GHB_l2c_pref {
+
+#define COMPONENT_NAME "GHB.l2c_pref"
+#include "component_impl.h"
+#include "prefetcher/GHB.l2c_pref"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace ip_stride_l2c_pref {
+
+#define COMPONENT_NAME "ip_stride.l2c_pref"
+#include "component_impl.h"
+#include "prefetcher/ip_stride.l2c_pref"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace ip_stride_llc_pref {
+
+#define COMPONENT_NAME "ip_stride.llc_pref"
+#include "component_impl.h"
+#include "prefetcher/ip_stride.llc_pref"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace next_line_l2c_pref {
+
+#define COMPONENT_NAME "next_line.l2c_pref"
+#include "component_impl.h"
+#include "prefetcher/next_line.l2c_pref"
+
+}
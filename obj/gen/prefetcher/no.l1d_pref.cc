@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace no_l1d_pref {
+
+#define COMPONENT_NAME "no.l1d_pref"
+#include "component_impl.h"
+#include "prefetcher/no.l1d_pref"
+
+}
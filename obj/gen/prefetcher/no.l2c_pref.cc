@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace no_l2c_pref {
+
+#define COMPONENT_NAME "no.l2c_pref"
+#include "component_impl.h"
+#include "prefetcher/no.l2c_pref"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace no_llc_pref {
+
+#define COMPONENT_NAME "no.llc_pref"
+#include "component_impl.h"
+#include "prefetcher/no.llc_pref"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace pangloss_l1d_pref {
+
+#define COMPONENT_NAME "pangloss.l1d_pref"
+#include "component_impl.h"
+#include "prefetcher/pangloss.l1d_pref"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace pangloss_l2c_pref {
+
+#define COMPONENT_NAME "pangloss.l2c_pref"
+#include "component_impl.h"
+#include "prefetcher/pangloss.l2c_pref"
+
+}
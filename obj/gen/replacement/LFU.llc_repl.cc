@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace LFU_llc_repl {
+
+#define COMPONENT_NAME "LFU.llc_repl"
+#include "component_impl.h"
+#include "replacement/LFU.llc_repl"
+
+}
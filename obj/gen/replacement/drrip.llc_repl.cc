@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace drrip_llc_repl {
+
+#define COMPONENT_NAME "drrip.llc_repl"
+#include "component_impl.h"
+#include "replacement/drrip.llc_repl"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace lru_llc_repl {
+
+#define COMPONENT_NAME "lru.llc_repl"
+#include "component_impl.h"
+#include "replacement/lru.llc_repl"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace red_llc_repl {
+
+#define COMPONENT_NAME "red.llc_repl"
+#include "component_impl.h"
+#include "replacement/red.llc_repl"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace red_lfu_llc_repl {
+
+#define COMPONENT_NAME "red_lfu.llc_repl"
+#include "component_impl.h"
+#include "replacement/red_lfu.llc_repl"
+
+}
@@ -0,0 +1,12 @@
+#include "checkpoint.h"
+#include "shadow_llc.h"
+
+namespace shadow_llc_drrip {
+
+#include "shadow_llc_policy.h"
+#include "replacement/drrip.llc_repl"
+#include "replacement/base_replacement.cc"
+
+SHADOW_LLC_POLICY("drrip");
+
+}
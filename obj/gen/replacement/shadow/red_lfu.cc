@@ -0,0 +1,12 @@
+#include "checkpoint.h"
+#include "shadow_llc.h"
+
+namespace shadow_llc_red_lfu {
+
+#include "shadow_llc_policy.h"
+#include "replacement/red_lfu.llc_repl"
+#include "replacement/base_replacement.cc"
+
+SHADOW_LLC_POLICY("red_lfu");
+
+}
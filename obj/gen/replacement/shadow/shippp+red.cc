@@ -0,0 +1,14 @@
+#include <cstdlib>
+#include <ctime>
+#include "checkpoint.h"
+#include "shadow_llc.h"
+
+namespace shadow_llc_shippp_red {
+
+#include "shadow_llc_policy.h"
+#include "replacement/shippp+red.llc_repl"
+#include "replacement/base_replacement.cc"
+
+SHADOW_LLC_POLICY("shippp+red");
+
+}
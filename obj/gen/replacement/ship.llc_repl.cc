@@ -0,0 +1,12 @@
+#include <cstdlib>
+#include <ctime>
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace ship_llc_repl {
+
+#define COMPONENT_NAME "ship.llc_repl"
+#include "component_impl.h"
+#include "replacement/ship.llc_repl"
+
+}
@@ -0,0 +1,12 @@
+#include <cstdlib>
+#include <ctime>
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace shippp_red_llc_repl {
+
+#define COMPONENT_NAME "shippp+red.llc_repl"
+#include "component_impl.h"
+#include "replacement/shippp+red.llc_repl"
+
+}
@@ -0,0 +1,12 @@
+#include <cstdlib>
+#include <ctime>
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace shippp_llc_repl {
+
+#define COMPONENT_NAME "shippp.llc_repl"
+#include "component_impl.h"
+#include "replacement/shippp.llc_repl"
+
+}
@@ -0,0 +1,10 @@
+#include "ooo_cpu.h"
+#include "checkpoint.h"
+
+namespace srrip_llc_repl {
+
+#define COMPONENT_NAME "srrip.llc_repl"
+#include "component_impl.h"
+#include "replacement/srrip.llc_repl"
+
+}
@@ -0,0 +1,99 @@
+#!/bin/bash
+
+if [ "$#" -lt 6 ]; then
+    echo "Illegal number of parameters"
+    echo "Usage: ./run_quantum_drift.sh [BINARY] [N_WARM] [N_SIM] [QUANTUM] [THREADS] [TRACE0] [TRACE1] ..."
+    exit 1
+fi
+
+BINARY=${1}
+N_WARM=${2}
+N_SIM=${3}
+QUANTUM=${4}
+THREADS=${5}
+shift 5
+TRACES="$@"
+
+# Sanity check
+if [ ! -f "bin/$BINARY" ] ; then
+    echo "[ERROR] Cannot find a ChampSim binary: bin/$BINARY"
+    exit 1
+fi
+
+re='^[0-9]+$'
+if ! [[ $N_WARM =~ $re ]] || [ -z $N_WARM ] ; then
+    echo "[ERROR]: Number of warmup instructions is NOT a number" >&2;
+    exit 1
+fi
+
+if ! [[ $N_SIM =~ $re ]] || [ -z $N_SIM ] ; then
+    echo "[ERROR]: Number of simulation instructions is NOT a number" >&2;
+    exit 1
+fi
+
+if ! [[ $QUANTUM =~ $re ]] || [ "$QUANTUM" -lt 1 ] ; then
+    echo "[ERROR]: Quantum is NOT a positive number" >&2;
+    exit 1
+fi
+
+if ! [[ $THREADS =~ $re ]] || [ "$THREADS" -lt 1 ] ; then
+    echo "[ERROR]: Number of threads is NOT a positive number" >&2;
+    exit 1
+fi
+
+mkdir -p results_quantum_${N_SIM}M
+REF_OUT=results_quantum_${N_SIM}M/${BINARY}-lockstep.txt
+Q1_OUT=results_quantum_${N_SIM}M/${BINARY}-q1.txt
+RUN_OUT=results_quantum_${N_SIM}M/${BINARY}-q${QUANTUM}-t${THREADS}.txt
+
+# the lockstep engine is the reference
+START=$(date +%s)
+(./bin/${BINARY} -warmup_instructions ${N_WARM}000000 -simulation_instructions ${N_SIM}000000 -traces ${TRACES}) &> ${REF_OUT}
+REF_TIME=$(( $(date +%s) - START ))
+
+START=$(date +%s)
+(./bin/${BINARY} -warmup_instructions ${N_WARM}000000 -simulation_instructions ${N_SIM}000000 -sync_quantum ${QUANTUM} -threads ${THREADS} -traces ${TRACES}) &> ${RUN_OUT}
+RUN_TIME=$(( $(date +%s) - START ))
+
+echo "lockstep: ${REF_TIME} sec  quantum ${QUANTUM} (${THREADS} threads): ${RUN_TIME} sec"
+
+# quantum 1 on a single thread must give the lockstep results, only the wall time may differ
+(./bin/${BINARY} -warmup_instructions ${N_WARM}000000 -simulation_instructions ${N_SIM}000000 -sync_quantum 1 -traces ${TRACES}) &> ${Q1_OUT}
+if diff <(sed 's/ (Simulation time.*//' ${REF_OUT}) <(sed 's/ (Simulation time.*//' ${Q1_OUT}) > /dev/null ; then
+    echo "quantum 1 matches lockstep"
+else
+    echo "[ERROR] quantum 1 does NOT match lockstep: diff ${REF_OUT} ${Q1_OUT}" >&2
+    Q1_MISMATCH=1
+fi
+
+# IPC drift per core, taken from the "Finished CPU" lines and paired by CPU id
+# since the cores do not finish in the same order in both runs
+awk '
+$1 == "Finished" && $2 == "CPU" {
+    for (i=1; i<=NF; i++) {
+        if ($i == "IPC:")
+            ipc = $(i+1);
+    }
+    if (FNR == NR)
+        ref[$3] = ipc;
+    else
+        run[$3] = ipc;
+}
+END {
+    max_drift = 0;
+    for (cpu=0; cpu in ref; cpu++) {
+        drift = 100.0 * (run[cpu] - ref[cpu]) / ref[cpu];
+        if (drift < 0)
+            abs_drift = -drift;
+        else
+            abs_drift = drift;
+        if (abs_drift > max_drift)
+            max_drift = abs_drift;
+        printf("CPU %d IPC lockstep: %s quantum '${QUANTUM}': %s drift: %.3f%%\n", cpu, ref[cpu], run[cpu], drift);
+    }
+    printf("max IPC drift: %.3f%%\n", max_drift);
+}' ${REF_OUT} ${RUN_OUT}
+
+if [ -n "${Q1_MISMATCH}" ] ; then
+    exit 1
+fi
@@ -5,6 +5,7 @@ import sys
 args = argparse.ArgumentParser(description = 'Score simulator.')
 args.add_argument("bin_path", type = str, help = "bin_path")
 args.add_argument("traces_dir_path", type = str, help = "traces_dir_path")
+args.add_argument("--fast_forward", type = int, default = 0, help = "millions of the 50M warmup instructions to fast-forward functionally")
 args = args.parse_args() 
 
 # check
@@ -33,13 +34,21 @@ for path,d,filelist in os.walk(trace_file_path):
         t = os.path.join(path,filename)
         traces.append(t)
         
-cmd = "./run_champsim.sh " + bin_path + " 50 100 "
+if args.fast_forward < 0 or args.fast_forward > 50:
+    print("illegal fast_forward!")
+    exit(0)
+
+# the fast-forwarded instructions replace part of the detailed warmup
+cmd = "./run_champsim.sh " + bin_path + " " + str(50 - args.fast_forward) + " 100 "
+option = ""
+if args.fast_forward:
+    option = " \"-fast_forward " + str(args.fast_forward) + "000000\""
 
 print("please wait...")
 student_num = "tmplog_" + bin_path.split('/')[2]
 log_num = 0
 for trace in traces:
-    trace_cmd = cmd + trace + "> " + student_num + "_" + str(log_num)
+    trace_cmd = cmd + trace + option + "> " + student_num + "_" + str(log_num)
     log_num = log_num + 1
     os.system(trace_cmd)
 
@@ -1,74 +1,181 @@
 #include "block.h"
 
+PACKET_POOL packet_pool;
+
+void PACKET_POOL::grow()
+{
+    // every packet of the pool can be on the free list at once
+    PACKET **grown = new PACKET*[num_packets + PACKET_POOL_CHUNK];
+    for (uint32_t i=0; i<num_free; i++)
+        grown[i] = free_packet[i];
+    delete[] free_packet;
+    free_packet = grown;
+
+    // the chunk stays allocated until the simulation ends
+    PACKET *chunk = new PACKET[PACKET_POOL_CHUNK];
+    for (uint32_t i=0; i<PACKET_POOL_CHUNK; i++)
+        free_packet[num_free++] = &chunk[i];
+    num_packets += PACKET_POOL_CHUNK;
+}
+
+void MSHR_INDEX::resize(uint32_t entries)
+{
+    release();
+
+    size = entries;
+    entry_of.resize(size);
+
+    free_entry = new uint64_t[(size+63)/64]();
+    for (uint32_t i=0; i<size; i++)
+        free_entry[i/64] |= 1ull << (i%64);
+
+    num_fills = 0;
+    fill = new uint32_t[size];
+    fill_position = new uint32_t[size];
+    fill_cycle = new uint64_t[size];
+    for (uint32_t i=0; i<size; i++)
+        fill_position[i] = UINT32_MAX;
+}
+
+void MSHR_INDEX::release()
+{
+    delete[] free_entry;
+    delete[] fill;
+    delete[] fill_position;
+    delete[] fill_cycle;
+}
+
+void MSHR_INDEX::insert(uint64_t addr, uint32_t index)
+{
+    free_entry[index/64] &= ~(1ull << (index%64));
+
+    // an entry to address 0 can only be found by a scan
+    if (addr == 0)
+        return;
+
+    entry_of.insert(addr) = index;
+}
+
+void MSHR_INDEX::erase(uint64_t addr, uint32_t index)
+{
+    free_entry[index/64] |= 1ull << (index%64);
+    remove_fill(index);
+
+    if (addr == 0)
+        return;
+
+    uint32_t i = entry_of.slot(addr);
+    if (entry_of.address[i] && (entry_of.value[i] == index))
+        entry_of.erase_slot(i);
+}
+
+// the entry has returned and fills at cycle, it may already be waiting to fill
+void MSHR_INDEX::update_fill(uint32_t index, uint64_t cycle)
+{
+    fill_cycle[index] = cycle;
+    if (fill_position[index] == UINT32_MAX)
+        place_fill(index, num_fills++);
+
+    sift_up(fill_position[index]);
+    sift_down(fill_position[index]);
+}
+
+void MSHR_INDEX::remove_fill(uint32_t index)
+{
+    uint32_t position = fill_position[index];
+    if (position == UINT32_MAX)
+        return;
+
+    fill_position[index] = UINT32_MAX;
+    uint32_t last = fill[--num_fills];
+    if (position == num_fills)
+        return;
+
+    place_fill(last, position);
+    sift_up(position);
+    sift_down(fill_position[last]);
+}
+
+void MSHR_INDEX::place_fill(uint32_t index, uint32_t position)
+{
+    fill[position] = index;
+    fill_position[index] = position;
+}
+
+void MSHR_INDEX::sift_up(uint32_t position)
+{
+    while (position > 0) {
+        uint32_t parent = (position - 1) / 2, index = fill[position];
+        if (!earlier(index, fill[parent]))
+            break;
+
+        place_fill(fill[parent], position);
+        place_fill(index, parent);
+        position = parent;
+    }
+}
+
+void MSHR_INDEX::sift_down(uint32_t position)
+{
+    while (1) {
+        uint32_t first = position, child = 2*position + 1;
+        if ((child < num_fills) && earlier(fill[child], fill[first]))
+            first = child;
+        if ((child + 1 < num_fills) && earlier(fill[child + 1], fill[first]))
+            first = child + 1;
+        if (first == position)
+            break;
+
+        uint32_t index = fill[position];
+        place_fill(fill[first], position);
+        place_fill(index, first);
+        position = first;
+    }
+}
+
+void PACKET_QUEUE::allocate()
+{
+    entry.packet = new PACKET*[SIZE];
+    for (uint32_t i=0; i<SIZE; i++)
+        entry.packet[i] = packet_pool.allocate();
+}
+
+void PACKET_QUEUE::release()
+{
+    if (entry.packet == NULL)
+        return;
+
+    for (uint32_t i=0; i<SIZE; i++)
+        packet_pool.release(entry.packet[i]);
+    delete[] entry.packet;
+    entry.packet = NULL;
+}
+
 int PACKET_QUEUE::check_queue(PACKET *packet)
 {
     if ((head == tail) && occupancy == 0)
         return -1;
 
-    if (head < tail) {
-        for (uint32_t i=head; i<tail; i++) {
-            if (NAME == "L1D_WQ") {
-                if (entry[i].full_addr == packet->full_addr) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
-            else {
-                if (entry[i].address == packet->address) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
-        }
-    }
-    else {
-        for (uint32_t i=head; i<SIZE; i++) {
-            if (NAME == "L1D_WQ") {
-                if (entry[i].full_addr == packet->full_addr) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
-            else {
-                if (entry[i].address == packet->address) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
-        }
-        for (uint32_t i=0; i<tail; i++) {
-            if (NAME == "L1D_WQ") {
-                if (entry[i].full_addr == packet->full_addr) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
-            else {
-                if (entry[i].address == packet->address) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
+    // most packets match no entry, their count tells so without a search
+    uint64_t addr = match_address(*packet);
+    if ((match != QUEUE_MATCH_NONE) && addr && (address_count.find(addr) == 0))
+        return -1;
+
+    // the oldest matching entry
+    uint32_t i = head;
+    do {
+        if (match_address(entry[i]) == addr) {
+            DP (if (warmup_complete[packet->cpu]) {
+            cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
+            cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
+            cout << " cycle " << packet->event_cycle << endl; });
+            return i;
         }
-    }
+
+        i++;
+        if (i == SIZE)
+            i = 0;
+    } while (i != tail);
 
     return -1;
 }
@@ -82,6 +189,7 @@ void PACKET_QUEUE::add_queue(PACKET *packet)
 
     // add entry
     entry[tail] = *packet;
+    index_entry(tail);
 
     DP ( if (warmup_complete[packet->cpu]) {
     cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id;
@@ -94,6 +202,34 @@ void PACKET_QUEUE::add_queue(PACKET *packet)
         tail = 0;
 }
 
+// adds the packet at index of source without copying it, source is left with the empty packet
+// that was at the tail and still has to remove the entry
+void PACKET_QUEUE::move_queue(PACKET_QUEUE &source, uint32_t index)
+{
+#ifdef SANITY_CHECK
+    if (occupancy && (head == tail))
+        assert(0);
+#endif
+
+    PACKET *packet = source.entry.packet[index];
+    if (source.match != QUEUE_MATCH_NONE)
+        source.address_count.erase(source.match_address(*packet));
+
+    source.entry.packet[index] = entry.packet[tail];
+    entry.packet[tail] = packet;
+    index_entry(tail);
+
+    DP ( if (warmup_complete[packet->cpu]) {
+    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " from: " << source.NAME;
+    cout << " address: " << hex << packet->address << " full_addr: " << packet->full_addr << dec;
+    cout << " head: " << head << " tail: " << tail << " occupancy: " << occupancy << " event_cycle: " << packet->event_cycle << endl; });
+
+    occupancy++;
+    tail++;
+    if (tail >= SIZE)
+        tail = 0;
+}
+
 void PACKET_QUEUE::remove_queue(PACKET *packet)
 {
 #ifdef SANITY_CHECK
@@ -106,6 +242,9 @@ void PACKET_QUEUE::remove_queue(PACKET *packet)
     cout << " address: " << hex << packet->address << " full_addr: " << packet->full_addr << dec << " fill_level: " << packet->fill_level;
     cout << " head: " << head << " tail: " << tail << " occupancy: " << occupancy << " event_cycle: " << packet->event_cycle << endl; });
 
+    if (match != QUEUE_MATCH_NONE)
+        address_count.erase(match_address(*packet));
+
     // reset entry
     PACKET empty_packet;
     *packet = empty_packet;
@@ -1,72 +1,90 @@
 #include "cache.h"
+#include "ooo_cpu.h"
 #include "set.h"
+#include "shadow_llc.h"
 
 uint64_t l2pf_access = 0;
+std::mutex prefetcher_mutex;
 
-void print_cache_config()
+CACHE_CONFIG itlb_config = {ITLB_SET, ITLB_WAY, ITLB_RQ_SIZE, ITLB_WQ_SIZE, ITLB_PQ_SIZE, ITLB_MSHR_SIZE, ITLB_LATENCY},
+             dtlb_config = {DTLB_SET, DTLB_WAY, DTLB_RQ_SIZE, DTLB_WQ_SIZE, DTLB_PQ_SIZE, DTLB_MSHR_SIZE, DTLB_LATENCY},
+             stlb_config = {STLB_SET, STLB_WAY, STLB_RQ_SIZE, STLB_WQ_SIZE, STLB_PQ_SIZE, STLB_MSHR_SIZE, STLB_LATENCY},
+             l1i_config = {L1I_SET, L1I_WAY, L1I_RQ_SIZE, L1I_WQ_SIZE, L1I_PQ_SIZE, L1I_MSHR_SIZE, L1I_LATENCY},
+             l1d_config = {L1D_SET, L1D_WAY, L1D_RQ_SIZE, L1D_WQ_SIZE, L1D_PQ_SIZE, L1D_MSHR_SIZE, L1D_LATENCY},
+             l2c_config = {L2C_SET, L2C_WAY, L2C_RQ_SIZE, L2C_WQ_SIZE, L2C_PQ_SIZE, L2C_MSHR_SIZE, L2C_LATENCY},
+             llc_config = {LLC_SET, LLC_WAY, LLC_RQ_SIZE, LLC_WQ_SIZE, LLC_PQ_SIZE, LLC_MSHR_SIZE, LLC_LATENCY};
+
+static void print_cache_level(const char *name, const CACHE_CONFIG &config, uint8_t print_size)
 {
-    cout << "itlb_set " << ITLB_SET << endl
-        << "itlb_way " << ITLB_WAY << endl
-        << "itlb_rq_size " << ITLB_RQ_SIZE << endl
-        << "itlb_wq_size " << ITLB_WQ_SIZE << endl
-        << "itlb_pq_size " << ITLB_PQ_SIZE << endl
-        << "itlb_mshr_size " << ITLB_MSHR_SIZE << endl
-        << "itlb_latency " << ITLB_LATENCY << endl
-        << endl
-        << "dtlb_set " << DTLB_SET << endl
-        << "dtlb_way " << DTLB_WAY << endl
-        << "dtlb_rq_size " << DTLB_RQ_SIZE << endl
-        << "dtlb_wq_size " << DTLB_WQ_SIZE << endl
-        << "dtlb_pq_size " << DTLB_PQ_SIZE << endl
-        << "dtlb_mshr_size " << DTLB_MSHR_SIZE << endl
-        << "dtlb_latency " << DTLB_LATENCY << endl
-        << endl
-        << "stlb_set " << STLB_SET << endl
-        << "stlb_way " << STLB_WAY << endl
-        << "stlb_rq_size " << STLB_RQ_SIZE << endl
-        << "stlb_wq_size " << STLB_WQ_SIZE << endl
-        << "stlb_pq_size " << STLB_PQ_SIZE << endl
-        << "stlb_mshr_size " << STLB_MSHR_SIZE << endl
-        << "stlb_latency " << STLB_LATENCY << endl
-        << endl
-        << "l1i_size " << (L1I_SET*L1I_WAY*BLOCK_SIZE)/1024 << endl
-        << "l1i_set " << L1I_SET << endl
-        << "l1i_way " << L1I_WAY << endl
-        << "l1i_rq_size " << L1I_RQ_SIZE << endl
-        << "l1i_wq_size " << L1I_WQ_SIZE << endl
-        << "l1i_pq_size " << L1I_PQ_SIZE << endl
-        << "l1i_mshr_size " << L1I_MSHR_SIZE << endl
-        << "l1i_latency " << L1I_LATENCY << endl
-        << endl
-        << "l1d_size " << (L1D_SET*L1D_WAY*BLOCK_SIZE)/1024 << endl
-        << "l1d_set " << L1D_SET << endl
-        << "l1d_way " << L1D_WAY << endl
-        << "l1d_rq_size " << L1D_RQ_SIZE << endl
-        << "l1d_wq_size " << L1D_WQ_SIZE << endl
-        << "l1d_pq_size " << L1D_PQ_SIZE << endl
-        << "l1d_mshr_size " << L1D_MSHR_SIZE << endl
-        << "l1d_latency " << L1D_LATENCY << endl
-        << endl
-        << "l2c_size " << (L2C_SET*L2C_WAY*BLOCK_SIZE)/1024 << endl
-        << "l2c_set " << L2C_SET << endl
-        << "l2c_way " << L2C_WAY << endl
-        << "l2c_rq_size " << L2C_RQ_SIZE << endl
-        << "l2c_wq_size " << L2C_WQ_SIZE << endl
-        << "l2c_pq_size " << L2C_PQ_SIZE << endl
-        << "l2c_mshr_size " << L2C_MSHR_SIZE << endl
-        << "l2c_latency " << L2C_LATENCY << endl
-        << endl
-        << "llc_size " << (LLC_SET*LLC_WAY*BLOCK_SIZE)/1024 << endl
-        << "llc_set " << LLC_SET << endl
-        << "llc_way " << LLC_WAY << endl
-        << "llc_rq_size " << LLC_RQ_SIZE << endl
-        << "llc_wq_size " << LLC_WQ_SIZE << endl
-        << "llc_pq_size " << LLC_PQ_SIZE << endl
-        << "llc_mshr_size " << LLC_MSHR_SIZE << endl
-        << "llc_latency " << LLC_LATENCY << endl
+    if (print_size)
+        cout << name << "_size " << (config.sets*config.ways*BLOCK_SIZE)/1024 << endl;
+
+    cout << name << "_set " << config.sets << endl
+        << name << "_way " << config.ways << endl
+        << name << "_rq_size " << config.rq_size << endl
+        << name << "_wq_size " << config.wq_size << endl
+        << name << "_pq_size " << config.pq_size << endl
+        << name << "_mshr_size " << config.mshr_size << endl
+        << name << "_latency " << config.latency << endl
         << endl;
 }
 
+void print_cache_config()
+{
+    print_cache_level("itlb", itlb_config, 0);
+    print_cache_level("dtlb", dtlb_config, 0);
+    print_cache_level("stlb", stlb_config, 0);
+    print_cache_level("l1i", l1i_config, 1);
+    print_cache_level("l1d", l1d_config, 1);
+    print_cache_level("l2c", l2c_config, 1);
+    print_cache_level("llc", llc_config, 1);
+}
+
+// called before the simulation starts, only what differs from the compiled geometry is reallocated
+void CACHE::configure(const CACHE_CONFIG &config)
+{
+    if ((config.sets != NUM_SET) || (config.ways != NUM_WAY)) {
+        for (uint32_t i=0; i<NUM_SET; i++)
+            delete[] block[i];
+        delete[] block;
+
+        NUM_SET = config.sets;
+        NUM_WAY = config.ways;
+        NUM_LINE = NUM_SET*NUM_WAY;
+        set_mask = (1 << lg2(NUM_SET)) - 1;
+
+        block = new BLOCK* [NUM_SET];
+        for (uint32_t i=0; i<NUM_SET; i++) {
+            block[i] = new BLOCK[NUM_WAY];
+
+            for (uint32_t j=0; j<NUM_WAY; j++)
+                block[i][j].lru = j;
+        }
+
+        delete[] way_tag;
+        allocate_tags();
+    }
+
+    if (config.wq_size != WQ_SIZE) {
+        WQ_SIZE = config.wq_size;
+        WQ.resize(WQ_SIZE);
+    }
+    if (config.rq_size != RQ_SIZE) {
+        RQ_SIZE = config.rq_size;
+        RQ.resize(RQ_SIZE);
+    }
+    if (config.pq_size != PQ_SIZE) {
+        PQ_SIZE = config.pq_size;
+        PQ.resize(PQ_SIZE);
+    }
+    if (config.mshr_size != MSHR_SIZE) {
+        MSHR_SIZE = config.mshr_size;
+        MSHR.resize(MSHR_SIZE);
+        mshr_lookup.resize(MSHR_SIZE);
+    }
+}
+
+template <uint8_t CACHE_TYPE>
 void CACHE::handle_fill()
 {
     // handle fill
@@ -85,17 +103,17 @@ void CACHE::handle_fill()
 
         // find victim
         uint32_t set = get_set(MSHR.entry[mshr_index].address), way;
-        if (cache_type == IS_LLC) {
+        if (CACHE_TYPE == IS_LLC) {
             way = llc_find_victim(fill_cpu, MSHR.entry[mshr_index].instr_id, set, block[set], MSHR.entry[mshr_index].ip, MSHR.entry[mshr_index].full_addr, MSHR.entry[mshr_index].type);
         }
         else
             way = find_victim(fill_cpu, MSHR.entry[mshr_index].instr_id, set, block[set], MSHR.entry[mshr_index].ip, MSHR.entry[mshr_index].full_addr, MSHR.entry[mshr_index].type);
 
 #ifdef LLC_BYPASS
-        if ((cache_type == IS_LLC) && (way == LLC_WAY)) { // this is a bypass that does not fill the LLC
+        if ((CACHE_TYPE == IS_LLC) && (way == LLC_WAY)) { // this is a bypass that does not fill the LLC
 
             // update replacement policy
-            if (cache_type == IS_LLC) {
+            if (CACHE_TYPE == IS_LLC) {
                 llc_update_replacement_state(fill_cpu, set, way, MSHR.entry[mshr_index].full_addr, MSHR.entry[mshr_index].ip, 0, MSHR.entry[mshr_index].type, 0);
 
             }
@@ -121,6 +139,7 @@ void CACHE::handle_fill()
 		total_miss_latency += current_miss_latency;
 	      }
 
+            mshr_lookup.erase(MSHR.entry[mshr_index].address, mshr_index);
             MSHR.remove_queue(&MSHR.entry[mshr_index]);
             MSHR.num_returned--;
 
@@ -168,7 +187,7 @@ void CACHE::handle_fill()
 #ifdef SANITY_CHECK
             else {
                 // sanity check
-                if (cache_type != IS_STLB)
+                if (CACHE_TYPE != IS_STLB)
                     assert(0);
             }
 #endif
@@ -176,13 +195,14 @@ void CACHE::handle_fill()
 
         if (do_fill){
             // update prefetcher
-            if (cache_type == IS_L1D)
+            PREFETCHER_LOCK prefetcher_lock;
+            if (CACHE_TYPE == IS_L1D)
 	      l1d_prefetcher_cache_fill(MSHR.entry[mshr_index].full_addr, set, way, (MSHR.entry[mshr_index].type == PREFETCH) ? 1 : 0, block[set][way].address<<LOG2_BLOCK_SIZE,
 					MSHR.entry[mshr_index].pf_metadata);
-            if  (cache_type == IS_L2C)
+            if  (CACHE_TYPE == IS_L2C)
 	      MSHR.entry[mshr_index].pf_metadata = l2c_prefetcher_cache_fill(MSHR.entry[mshr_index].address<<LOG2_BLOCK_SIZE, set, way, (MSHR.entry[mshr_index].type == PREFETCH) ? 1 : 0,
 									     block[set][way].address<<LOG2_BLOCK_SIZE, MSHR.entry[mshr_index].pf_metadata);
-            if (cache_type == IS_LLC)
+            if (CACHE_TYPE == IS_LLC)
 	      {
 		cpu = fill_cpu;
 		MSHR.entry[mshr_index].pf_metadata = llc_prefetcher_cache_fill(MSHR.entry[mshr_index].address<<LOG2_BLOCK_SIZE, set, way, (MSHR.entry[mshr_index].type == PREFETCH) ? 1 : 0,
@@ -191,7 +211,7 @@ void CACHE::handle_fill()
 	      }
               
             // update replacement policy
-            if (cache_type == IS_LLC) {
+            if (CACHE_TYPE == IS_LLC) {
                 llc_update_replacement_state(fill_cpu, set, way, MSHR.entry[mshr_index].full_addr, MSHR.entry[mshr_index].ip, block[set][way].full_addr, MSHR.entry[mshr_index].type, 0);
             }
             else
@@ -204,7 +224,7 @@ void CACHE::handle_fill()
             fill_cache(set, way, &MSHR.entry[mshr_index]);
 
             // RFO marks cache line dirty
-            if (cache_type == IS_L1D) {
+            if (CACHE_TYPE == IS_L1D) {
                 if (MSHR.entry[mshr_index].type == RFO)
                     block[set][way].dirty = 1;
             }
@@ -218,33 +238,35 @@ void CACHE::handle_fill()
                     upper_level_dcache[fill_cpu]->return_data(&MSHR.entry[mshr_index]);
             }
 
-            // update processed packets
-            if (cache_type == IS_ITLB) { 
+	    if(warmup_complete[fill_cpu])
+	      {
+		uint64_t current_miss_latency = (current_core_cycle[fill_cpu] - MSHR.entry[mshr_index].cycle_enqueued);
+		total_miss_latency += current_miss_latency;
+	      }
+	  
+            mshr_lookup.erase(MSHR.entry[mshr_index].address, mshr_index);
+
+            // update processed packets, the MSHR entry itself moves to PROCESSED
+            if (CACHE_TYPE == IS_ITLB) { 
                 MSHR.entry[mshr_index].instruction_pa = block[set][way].data;
                 if (PROCESSED.occupancy < PROCESSED.SIZE)
-                    PROCESSED.add_queue(&MSHR.entry[mshr_index]);
+                    PROCESSED.move_queue(MSHR, mshr_index);
             }
-            else if (cache_type == IS_DTLB) {
+            else if (CACHE_TYPE == IS_DTLB) {
                 MSHR.entry[mshr_index].data_pa = block[set][way].data;
                 if (PROCESSED.occupancy < PROCESSED.SIZE)
-                    PROCESSED.add_queue(&MSHR.entry[mshr_index]);
+                    PROCESSED.move_queue(MSHR, mshr_index);
             }
-            else if (cache_type == IS_L1I) {
+            else if (CACHE_TYPE == IS_L1I) {
                 if (PROCESSED.occupancy < PROCESSED.SIZE)
-                    PROCESSED.add_queue(&MSHR.entry[mshr_index]);
+                    PROCESSED.move_queue(MSHR, mshr_index);
             }
-            //else if (cache_type == IS_L1D) {
-            else if ((cache_type == IS_L1D) && (MSHR.entry[mshr_index].type != PREFETCH)) {
+            //else if (CACHE_TYPE == IS_L1D) {
+            else if ((CACHE_TYPE == IS_L1D) && (MSHR.entry[mshr_index].type != PREFETCH)) {
                 if (PROCESSED.occupancy < PROCESSED.SIZE)
-                    PROCESSED.add_queue(&MSHR.entry[mshr_index]);
+                    PROCESSED.move_queue(MSHR, mshr_index);
             }
 
-	    if(warmup_complete[fill_cpu])
-	      {
-		uint64_t current_miss_latency = (current_core_cycle[fill_cpu] - MSHR.entry[mshr_index].cycle_enqueued);
-		total_miss_latency += current_miss_latency;
-	      }
-	  
             MSHR.remove_queue(&MSHR.entry[mshr_index]);
             MSHR.num_returned--;
 
@@ -253,6 +275,7 @@ void CACHE::handle_fill()
     }
 }
 
+template <uint8_t CACHE_TYPE>
 void CACHE::handle_writeback()
 {
     // handle write
@@ -270,7 +293,7 @@ void CACHE::handle_writeback()
         
         if (way >= 0) { // writeback hit (or RFO hit for L1D)
 
-            if (cache_type == IS_LLC) {
+            if (CACHE_TYPE == IS_LLC) {
                 llc_update_replacement_state(writeback_cpu, set, way, block[set][way].full_addr, WQ.entry[index].ip, 0, WQ.entry[index].type, 1);
 
             }
@@ -284,11 +307,11 @@ void CACHE::handle_writeback()
             // mark dirty
             block[set][way].dirty = 1;
 
-            if (cache_type == IS_ITLB)
+            if (CACHE_TYPE == IS_ITLB)
                 WQ.entry[index].instruction_pa = block[set][way].data;
-            else if (cache_type == IS_DTLB)
+            else if (CACHE_TYPE == IS_DTLB)
                 WQ.entry[index].data_pa = block[set][way].data;
-            else if (cache_type == IS_STLB)
+            else if (CACHE_TYPE == IS_STLB)
                 WQ.entry[index].data = block[set][way].data;
 
             // check fill level
@@ -302,6 +325,8 @@ void CACHE::handle_writeback()
 
             HIT[WQ.entry[index].type]++;
             ACCESS[WQ.entry[index].type]++;
+            if (CACHE_TYPE == IS_LLC)
+                shadow_llc_access(&WQ.entry[index]);
 
             // remove this entry from WQ
             WQ.remove_queue(&WQ.entry[index]);
@@ -314,7 +339,7 @@ void CACHE::handle_writeback()
             cout << " full_addr: " << WQ.entry[index].full_addr << dec;
             cout << " cycle: " << WQ.entry[index].event_cycle << endl; });
 
-            if (cache_type == IS_L1D) { // RFO miss
+            if (CACHE_TYPE == IS_L1D) { // RFO miss
 
                 // check mshr
                 uint8_t miss_handled = 1;
@@ -322,7 +347,7 @@ void CACHE::handle_writeback()
 
                 if ((mshr_index == -1) && (MSHR.occupancy < MSHR_SIZE)) { // this is a new miss
 
-		  if(cache_type == IS_LLC)
+		  if(CACHE_TYPE == IS_LLC)
 		    {
 		      // check to make sure the DRAM RQ has room for this LLC RFO miss
 		      if (lower_level->get_occupancy(1, WQ.entry[index].address) == lower_level->get_size(1, WQ.entry[index].address))
@@ -388,6 +413,8 @@ void CACHE::handle_writeback()
 
                     MISS[WQ.entry[index].type]++;
                     ACCESS[WQ.entry[index].type]++;
+                    if (CACHE_TYPE == IS_LLC)
+                        shadow_llc_access(&WQ.entry[index]);
 
                     // remove this entry from WQ
                     WQ.remove_queue(&WQ.entry[index]);
@@ -397,14 +424,14 @@ void CACHE::handle_writeback()
             else {
                 // find victim
                 uint32_t set = get_set(WQ.entry[index].address), way;
-                if (cache_type == IS_LLC) {
+                if (CACHE_TYPE == IS_LLC) {
                     way = llc_find_victim(writeback_cpu, WQ.entry[index].instr_id, set, block[set], WQ.entry[index].ip, WQ.entry[index].full_addr, WQ.entry[index].type);
                 }
                 else
                     way = find_victim(writeback_cpu, WQ.entry[index].instr_id, set, block[set], WQ.entry[index].ip, WQ.entry[index].full_addr, WQ.entry[index].type);
 
 #ifdef LLC_BYPASS
-                if ((cache_type == IS_LLC) && (way == LLC_WAY)) {
+                if ((CACHE_TYPE == IS_LLC) && (way == LLC_WAY)) {
                     cerr << "LLC bypassing for writebacks is not allowed!" << endl;
                     assert(0);
                 }
@@ -448,7 +475,7 @@ void CACHE::handle_writeback()
 #ifdef SANITY_CHECK
                     else {
                         // sanity check
-                        if (cache_type != IS_STLB)
+                        if (CACHE_TYPE != IS_STLB)
                             assert(0);
                     }
 #endif
@@ -456,12 +483,13 @@ void CACHE::handle_writeback()
 
                 if (do_fill) {
                     // update prefetcher
-                    if (cache_type == IS_L1D)
+                    PREFETCHER_LOCK prefetcher_lock;
+                    if (CACHE_TYPE == IS_L1D)
 		      l1d_prefetcher_cache_fill(WQ.entry[index].full_addr, set, way, 0, block[set][way].address<<LOG2_BLOCK_SIZE, WQ.entry[index].pf_metadata);
-                    else if (cache_type == IS_L2C)
+                    else if (CACHE_TYPE == IS_L2C)
 		      WQ.entry[index].pf_metadata = l2c_prefetcher_cache_fill(WQ.entry[index].address<<LOG2_BLOCK_SIZE, set, way, 0,
 									      block[set][way].address<<LOG2_BLOCK_SIZE, WQ.entry[index].pf_metadata);
-                    if (cache_type == IS_LLC)
+                    if (CACHE_TYPE == IS_LLC)
 		      {
 			cpu = writeback_cpu;
 			WQ.entry[index].pf_metadata =llc_prefetcher_cache_fill(WQ.entry[index].address<<LOG2_BLOCK_SIZE, set, way, 0,
@@ -470,7 +498,7 @@ void CACHE::handle_writeback()
 		      }
 
                     // update replacement policy
-                    if (cache_type == IS_LLC) {
+                    if (CACHE_TYPE == IS_LLC) {
                         llc_update_replacement_state(writeback_cpu, set, way, WQ.entry[index].full_addr, WQ.entry[index].ip, block[set][way].full_addr, WQ.entry[index].type, 0);
                     }
                     else
@@ -496,6 +524,8 @@ void CACHE::handle_writeback()
 
                     MISS[WQ.entry[index].type]++;
                     ACCESS[WQ.entry[index].type]++;
+                    if (CACHE_TYPE == IS_LLC)
+                        shadow_llc_access(&WQ.entry[index]);
 
                     // remove this entry from WQ
                     WQ.remove_queue(&WQ.entry[index]);
@@ -505,6 +535,7 @@ void CACHE::handle_writeback()
     }
 }
 
+template <uint8_t CACHE_TYPE>
 void CACHE::handle_read()
 {
     // handle read
@@ -527,35 +558,32 @@ void CACHE::handle_read()
             
             if (way >= 0) { // read hit
 
-                if (cache_type == IS_ITLB) {
+                // the RQ entry itself moves to PROCESSED once the hit is handled
+                uint8_t processed = 0;
+                if (CACHE_TYPE == IS_ITLB) {
                     RQ.entry[index].instruction_pa = block[set][way].data;
-                    if (PROCESSED.occupancy < PROCESSED.SIZE)
-                        PROCESSED.add_queue(&RQ.entry[index]);
+                    processed = 1;
                 }
-                else if (cache_type == IS_DTLB) {
+                else if (CACHE_TYPE == IS_DTLB) {
                     RQ.entry[index].data_pa = block[set][way].data;
-                    if (PROCESSED.occupancy < PROCESSED.SIZE)
-                        PROCESSED.add_queue(&RQ.entry[index]);
+                    processed = 1;
                 }
-                else if (cache_type == IS_STLB) 
+                else if (CACHE_TYPE == IS_STLB) 
                     RQ.entry[index].data = block[set][way].data;
-                else if (cache_type == IS_L1I) {
-                    if (PROCESSED.occupancy < PROCESSED.SIZE)
-                        PROCESSED.add_queue(&RQ.entry[index]);
-                }
-                //else if (cache_type == IS_L1D) {
-                else if ((cache_type == IS_L1D) && (RQ.entry[index].type != PREFETCH)) {
-                    if (PROCESSED.occupancy < PROCESSED.SIZE)
-                        PROCESSED.add_queue(&RQ.entry[index]);
-                }
+                else if (CACHE_TYPE == IS_L1I)
+                    processed = 1;
+                //else if (CACHE_TYPE == IS_L1D) {
+                else if ((CACHE_TYPE == IS_L1D) && (RQ.entry[index].type != PREFETCH))
+                    processed = 1;
 
                 // update prefetcher on load instruction
 		if (RQ.entry[index].type == LOAD) {
-                    if (cache_type == IS_L1D) 
+                    PREFETCHER_LOCK prefetcher_lock;
+                    if (CACHE_TYPE == IS_L1D) 
 		      l1d_prefetcher_operate(RQ.entry[index].full_addr, RQ.entry[index].ip, 1, RQ.entry[index].type);
-                    else if (cache_type == IS_L2C)
+                    else if (CACHE_TYPE == IS_L2C)
 		      l2c_prefetcher_operate(block[set][way].address<<LOG2_BLOCK_SIZE, RQ.entry[index].ip, 1, RQ.entry[index].type, 0);
-                    else if (cache_type == IS_LLC)
+                    else if (CACHE_TYPE == IS_LLC)
 		      {
 			cpu = read_cpu;
 			llc_prefetcher_operate(block[set][way].address<<LOG2_BLOCK_SIZE, RQ.entry[index].ip, 1, RQ.entry[index].type, 0);
@@ -564,7 +592,7 @@ void CACHE::handle_read()
                 }
 
                 // update replacement policy
-                if (cache_type == IS_LLC) {
+                if (CACHE_TYPE == IS_LLC) {
                     llc_update_replacement_state(read_cpu, set, way, block[set][way].full_addr, RQ.entry[index].ip, 0, RQ.entry[index].type, 1);
 
                 }
@@ -593,7 +621,13 @@ void CACHE::handle_read()
 
                 HIT[RQ.entry[index].type]++;
                 ACCESS[RQ.entry[index].type]++;
+                if (CACHE_TYPE == IS_LLC)
+                    shadow_llc_access(&RQ.entry[index]);
                 
+                // update processed packets
+                if (processed && (PROCESSED.occupancy < PROCESSED.SIZE))
+                    PROCESSED.move_queue(RQ, index);
+
                 // remove this entry from RQ
                 RQ.remove_queue(&RQ.entry[index]);
 		reads_available_this_cycle--;
@@ -612,7 +646,7 @@ void CACHE::handle_read()
 
                 if ((mshr_index == -1) && (MSHR.occupancy < MSHR_SIZE)) { // this is a new miss
 
-		  if(cache_type == IS_LLC)
+		  if(CACHE_TYPE == IS_LLC)
 		    {
 		      // check to make sure the DRAM RQ has room for this LLC read miss
 		      if (lower_level->get_occupancy(1, RQ.entry[index].address) == lower_level->get_size(1, RQ.entry[index].address))
@@ -637,7 +671,7 @@ void CACHE::handle_read()
 		      if (lower_level)
                         lower_level->add_rq(&RQ.entry[index]);
 		      else { // this is the last level
-                        if (cache_type == IS_STLB) {
+                        if (CACHE_TYPE == IS_STLB) {
 			  // TODO: need to differentiate page table walk and actual swap
 			  
 			  // emulate page table walk
@@ -665,29 +699,30 @@ void CACHE::handle_read()
                             if (RQ.entry[index].tlb_access) {
                                 uint32_t sq_index = RQ.entry[index].sq_index;
                                 MSHR.entry[mshr_index].store_merged = 1;
-                                MSHR.entry[mshr_index].sq_index_depend_on_me.insert (sq_index);
-				MSHR.entry[mshr_index].sq_index_depend_on_me.join (RQ.entry[index].sq_index_depend_on_me, SQ_SIZE);
+                                MSHR.entry[mshr_index].dependents().sq_index_depend_on_me.insert (sq_index);
+                                if (RQ.entry[index].store_merged)
+				    MSHR.entry[mshr_index].dependents().sq_index_depend_on_me.join (RQ.entry[index].depend_on_me.sets->sq_index_depend_on_me, core_config.sq_size);
                             }
 
                             if (RQ.entry[index].load_merged) {
                                 //uint32_t lq_index = RQ.entry[index].lq_index; 
                                 MSHR.entry[mshr_index].load_merged = 1;
                                 //MSHR.entry[mshr_index].lq_index_depend_on_me[lq_index] = 1;
-				MSHR.entry[mshr_index].lq_index_depend_on_me.join (RQ.entry[index].lq_index_depend_on_me, LQ_SIZE);
+				MSHR.entry[mshr_index].dependents().lq_index_depend_on_me.join (RQ.entry[index].depend_on_me.sets->lq_index_depend_on_me, core_config.lq_size);
                             }
                         }
                         else {
                             if (RQ.entry[index].instruction) {
                                 uint32_t rob_index = RQ.entry[index].rob_index;
                                 MSHR.entry[mshr_index].instr_merged = 1;
-                                MSHR.entry[mshr_index].rob_index_depend_on_me.insert (rob_index);
+                                MSHR.entry[mshr_index].dependents().rob_index_depend_on_me.insert (rob_index);
 
                                 DP (if (warmup_complete[MSHR.entry[mshr_index].cpu]) {
                                 cout << "[INSTR_MERGED] " << __func__ << " cpu: " << MSHR.entry[mshr_index].cpu << " instr_id: " << MSHR.entry[mshr_index].instr_id;
                                 cout << " merged rob_index: " << rob_index << " instr_id: " << RQ.entry[index].instr_id << endl; });
 
                                 if (RQ.entry[index].instr_merged) {
-				    MSHR.entry[mshr_index].rob_index_depend_on_me.join (RQ.entry[index].rob_index_depend_on_me, ROB_SIZE);
+				    MSHR.entry[mshr_index].dependents().rob_index_depend_on_me.join (RQ.entry[index].depend_on_me.sets->rob_index_depend_on_me, core_config.rob_size);
                                     DP (if (warmup_complete[MSHR.entry[mshr_index].cpu]) {
                                     cout << "[INSTR_MERGED] " << __func__ << " cpu: " << MSHR.entry[mshr_index].cpu << " instr_id: " << MSHR.entry[mshr_index].instr_id;
                                     cout << " merged rob_index: " << i << " instr_id: N/A" << endl; });
@@ -697,15 +732,16 @@ void CACHE::handle_read()
                             {
                                 uint32_t lq_index = RQ.entry[index].lq_index;
                                 MSHR.entry[mshr_index].load_merged = 1;
-                                MSHR.entry[mshr_index].lq_index_depend_on_me.insert (lq_index);
+                                MSHR.entry[mshr_index].dependents().lq_index_depend_on_me.insert (lq_index);
 
                                 DP (if (warmup_complete[read_cpu]) {
                                 cout << "[DATA_MERGED] " << __func__ << " cpu: " << read_cpu << " instr_id: " << RQ.entry[index].instr_id;
                                 cout << " merged rob_index: " << RQ.entry[index].rob_index << " instr_id: " << RQ.entry[index].instr_id << " lq_index: " << RQ.entry[index].lq_index << endl; });
-				MSHR.entry[mshr_index].lq_index_depend_on_me.join (RQ.entry[index].lq_index_depend_on_me, LQ_SIZE);
+                                if (RQ.entry[index].load_merged)
+				    MSHR.entry[mshr_index].dependents().lq_index_depend_on_me.join (RQ.entry[index].depend_on_me.sets->lq_index_depend_on_me, core_config.lq_size);
                                 if (RQ.entry[index].store_merged) {
                                     MSHR.entry[mshr_index].store_merged = 1;
-				    MSHR.entry[mshr_index].sq_index_depend_on_me.join (RQ.entry[index].sq_index_depend_on_me, SQ_SIZE);
+				    MSHR.entry[mshr_index].dependents().sq_index_depend_on_me.join (RQ.entry[index].depend_on_me.sets->sq_index_depend_on_me, core_config.sq_size);
                                 }
                             }
                         }
@@ -745,11 +781,12 @@ void CACHE::handle_read()
                 if (miss_handled) {
                     // update prefetcher on load instruction
 		    if (RQ.entry[index].type == LOAD) {
-                        if (cache_type == IS_L1D) 
+                        PREFETCHER_LOCK prefetcher_lock;
+                        if (CACHE_TYPE == IS_L1D) 
                             l1d_prefetcher_operate(RQ.entry[index].full_addr, RQ.entry[index].ip, 0, RQ.entry[index].type);
-                        if (cache_type == IS_L2C)
+                        if (CACHE_TYPE == IS_L2C)
 			  l2c_prefetcher_operate(RQ.entry[index].address<<LOG2_BLOCK_SIZE, RQ.entry[index].ip, 0, RQ.entry[index].type, 0);
-                        if (cache_type == IS_LLC)
+                        if (CACHE_TYPE == IS_LLC)
 			  {
 			    cpu = read_cpu;
 			    llc_prefetcher_operate(RQ.entry[index].address<<LOG2_BLOCK_SIZE, RQ.entry[index].ip, 0, RQ.entry[index].type, 0);
@@ -759,6 +796,8 @@ void CACHE::handle_read()
 
                     MISS[RQ.entry[index].type]++;
                     ACCESS[RQ.entry[index].type]++;
+                    if (CACHE_TYPE == IS_LLC)
+                        shadow_llc_access(&RQ.entry[index]);
 
                     // remove this entry from RQ
                     RQ.remove_queue(&RQ.entry[index]);
@@ -778,6 +817,7 @@ void CACHE::handle_read()
     }
 }
 
+template <uint8_t CACHE_TYPE>
 void CACHE::handle_prefetch()
 {
     // handle prefetch
@@ -801,7 +841,7 @@ void CACHE::handle_prefetch()
             if (way >= 0) { // prefetch hit
 
                 // update replacement policy
-                if (cache_type == IS_LLC) {
+                if (CACHE_TYPE == IS_LLC) {
                     llc_update_replacement_state(prefetch_cpu, set, way, block[set][way].full_addr, PQ.entry[index].ip, 0, PQ.entry[index].type, 1);
 
                 }
@@ -815,11 +855,12 @@ void CACHE::handle_prefetch()
 		// run prefetcher on prefetches from higher caches
 		if(PQ.entry[index].pf_origin_level < fill_level)
 		  {
-		    if (cache_type == IS_L1D)
+		    PREFETCHER_LOCK prefetcher_lock;
+		    if (CACHE_TYPE == IS_L1D)
 		      l1d_prefetcher_operate(PQ.entry[index].full_addr, PQ.entry[index].ip, 1, PREFETCH);
-                    else if (cache_type == IS_L2C)
+                    else if (CACHE_TYPE == IS_L2C)
                       PQ.entry[index].pf_metadata = l2c_prefetcher_operate(block[set][way].address<<LOG2_BLOCK_SIZE, PQ.entry[index].ip, 1, PREFETCH, PQ.entry[index].pf_metadata);
-                    else if (cache_type == IS_LLC)
+                    else if (CACHE_TYPE == IS_LLC)
 		      {
 			cpu = prefetch_cpu;
 			PQ.entry[index].pf_metadata = llc_prefetcher_operate(block[set][way].address<<LOG2_BLOCK_SIZE, PQ.entry[index].ip, 1, PREFETCH, PQ.entry[index].pf_metadata);
@@ -838,6 +879,8 @@ void CACHE::handle_prefetch()
 
                 HIT[PQ.entry[index].type]++;
                 ACCESS[PQ.entry[index].type]++;
+                if (CACHE_TYPE == IS_LLC)
+                    shadow_llc_access(&PQ.entry[index]);
                 
                 // remove this entry from PQ
                 PQ.remove_queue(&PQ.entry[index]);
@@ -865,7 +908,7 @@ void CACHE::handle_prefetch()
                     // first check if the lower level PQ is full or not
                     // this is possible since multiple prefetchers can exist at each level of caches
                     if (lower_level) {
-		      if (cache_type == IS_LLC) {
+		      if (CACHE_TYPE == IS_LLC) {
 			if (lower_level->get_occupancy(1, PQ.entry[index].address) == lower_level->get_size(1, PQ.entry[index].address))
 			  miss_handled = 0;
 			else {
@@ -873,7 +916,7 @@ void CACHE::handle_prefetch()
 			  // run prefetcher on prefetches from higher caches
 			  if(PQ.entry[index].pf_origin_level < fill_level)
 			    {
-			      if (cache_type == IS_LLC)
+			      if (CACHE_TYPE == IS_LLC)
 				{
 				  cpu = prefetch_cpu;
 				  PQ.entry[index].pf_metadata = llc_prefetcher_operate(PQ.entry[index].address<<LOG2_BLOCK_SIZE, PQ.entry[index].ip, 0, PREFETCH, PQ.entry[index].pf_metadata);
@@ -896,9 +939,10 @@ void CACHE::handle_prefetch()
 			  // run prefetcher on prefetches from higher caches
 			  if(PQ.entry[index].pf_origin_level < fill_level)
 			    {
-			      if (cache_type == IS_L1D)
+			      PREFETCHER_LOCK prefetcher_lock;
+			      if (CACHE_TYPE == IS_L1D)
 				l1d_prefetcher_operate(PQ.entry[index].full_addr, PQ.entry[index].ip, 0, PREFETCH);
-			      if (cache_type == IS_L2C)
+			      if (CACHE_TYPE == IS_L2C)
 				PQ.entry[index].pf_metadata = l2c_prefetcher_operate(PQ.entry[index].address<<LOG2_BLOCK_SIZE, PQ.entry[index].ip, 0, PREFETCH, PQ.entry[index].pf_metadata);
 			    }
 			  
@@ -952,6 +996,8 @@ void CACHE::handle_prefetch()
 
                     MISS[PQ.entry[index].type]++;
                     ACCESS[PQ.entry[index].type]++;
+                    if (CACHE_TYPE == IS_LLC)
+                        shadow_llc_access(&PQ.entry[index]);
 
                     // remove this entry from PQ
                     PQ.remove_queue(&PQ.entry[index]);
@@ -971,26 +1017,160 @@ void CACHE::handle_prefetch()
     }
 }
 
-void CACHE::operate()
+template <uint8_t CACHE_TYPE>
+void CACHE::operate_as()
 {
-    handle_fill();
-    handle_writeback();
+    handle_fill<CACHE_TYPE>();
+    handle_writeback<CACHE_TYPE>();
     reads_available_this_cycle = MAX_READ;
-    handle_read();
+    handle_read<CACHE_TYPE>();
 
     if (PQ.occupancy && (reads_available_this_cycle > 0))
-        handle_prefetch();
+        handle_prefetch<CACHE_TYPE>();
+}
+
+void CACHE::operate()
+{
+    switch (cache_type) {
+        case IS_ITLB: operate_as<IS_ITLB>(); break;
+        case IS_DTLB: operate_as<IS_DTLB>(); break;
+        case IS_STLB: operate_as<IS_STLB>(); break;
+        case IS_L1I:  operate_as<IS_L1I>();  break;
+        case IS_L1D:  operate_as<IS_L1D>();  break;
+        case IS_L2C:  operate_as<IS_L2C>();  break;
+        case IS_LLC:  operate_as<IS_LLC>();  break;
+        default:
+            cerr << "[" << NAME << "] unknown cache type: " << +cache_type << endl;
+            assert(0);
+    }
 }
 
-uint32_t CACHE::get_set(uint64_t address)
+// earliest cycle at which operate() could do any work if nothing else is added to this cache
+uint64_t CACHE::get_next_event_cycle()
 {
-    return (uint32_t) (address & ((1 << lg2(NUM_SET)) - 1)); 
+    uint64_t next_event = UINT64_MAX;
+
+    if (MSHR.next_fill_index != MSHR_SIZE)
+        next_event = MSHR.next_fill_cycle;
+
+    PACKET_QUEUE *queue[3] = {&WQ, &RQ, &PQ};
+    for (uint32_t i=0; i<3; i++) {
+        if (queue[i]->occupancy && (queue[i]->entry[queue[i]->head].cpu != NUM_CPUS) && (queue[i]->entry[queue[i]->head].event_cycle < next_event))
+            next_event = queue[i]->entry[queue[i]->head].event_cycle;
+    }
+
+    return next_event;
+}
+
+void CACHE::functional_access(PACKET *packet)
+{
+    // same tag and replacement updates as the timing model, but the whole miss path is walked at once
+    // no stats are collected and prefetchers are not trained
+    uint32_t set = get_set(packet->address);
+    int way = check_hit(packet);
+
+    if (way >= 0) { // hit
+        if (cache_type == IS_LLC)
+            llc_update_replacement_state(packet->cpu, set, way, block[set][way].full_addr, packet->ip, 0, packet->type, 1);
+        else
+            update_replacement_state(packet->cpu, set, way, block[set][way].full_addr, packet->ip, 0, packet->type, 1);
+
+        if ((packet->type == WRITEBACK) || ((cache_type == IS_L1D) && (packet->type == RFO)))
+            block[set][way].dirty = 1;
+
+        packet->data = block[set][way].data;
+        return;
+    }
+
+    // miss, writebacks allocate without reading the lower level
+    if (packet->type != WRITEBACK) {
+        if (lower_level)
+            lower_level->functional_access(packet);
+        else if (cache_type == IS_STLB) {
+            // emulate page table walk
+            uint64_t pa = va_to_pa(packet->cpu, packet->instr_id, packet->full_addr, packet->address);
+
+            packet->data = pa >> LOG2_PAGE_SIZE;
+        }
+    }
+
+    // find victim
+    uint32_t victim_way;
+    if (cache_type == IS_LLC)
+        victim_way = llc_find_victim(packet->cpu, packet->instr_id, set, block[set], packet->ip, packet->full_addr, packet->type);
+    else
+        victim_way = find_victim(packet->cpu, packet->instr_id, set, block[set], packet->ip, packet->full_addr, packet->type);
+
+#ifdef LLC_BYPASS
+    if ((cache_type == IS_LLC) && (victim_way == LLC_WAY)) {
+        llc_update_replacement_state(packet->cpu, set, victim_way, packet->full_addr, packet->ip, 0, packet->type, 0);
+        return;
+    }
+#endif
+
+    if (block[set][victim_way].dirty && lower_level) {
+        PACKET writeback_packet;
+
+        writeback_packet.fill_level = fill_level << 1;
+        writeback_packet.cpu = packet->cpu;
+        writeback_packet.address = block[set][victim_way].address;
+        writeback_packet.full_addr = block[set][victim_way].full_addr;
+        writeback_packet.data = block[set][victim_way].data;
+        writeback_packet.instr_id = packet->instr_id;
+        writeback_packet.ip = 0; // writeback does not have ip
+        writeback_packet.type = WRITEBACK;
+
+        lower_level->functional_access(&writeback_packet);
+    }
+
+    if (cache_type == IS_LLC)
+        llc_update_replacement_state(packet->cpu, set, victim_way, packet->full_addr, packet->ip, block[set][victim_way].full_addr, packet->type, 0);
+    else
+        update_replacement_state(packet->cpu, set, victim_way, packet->full_addr, packet->ip, block[set][victim_way].full_addr, packet->type, 0);
+
+    fill_cache(set, victim_way, packet);
+
+    if ((packet->type == WRITEBACK) || ((cache_type == IS_L1D) && (packet->type == RFO)))
+        block[set][victim_way].dirty = 1;
 }
 
 uint32_t CACHE::get_way(uint64_t address, uint32_t set)
 {
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == address)) 
+    return find_tag(set, address);
+}
+
+// the valid way of the set holding tag, NUM_WAY if there is none
+uint32_t CACHE::find_tag(uint32_t set, uint64_t tag)
+{
+    const uint64_t *tags = &way_tag[set*NUM_WAY];
+    uint32_t way = 0;
+
+    // it would match the invalid ways
+    if (tag == INVALID_TAG)
+        return NUM_WAY;
+
+#if defined(__AVX2__)
+    __m256i tag4 = _mm256_set1_epi64x(tag);
+    for (; way+4 <= NUM_WAY; way += 4) {
+        __m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)&tags[way]), tag4);
+        int match = _mm256_movemask_pd(_mm256_castsi256_pd(equal));
+        if (match)
+            return way + __builtin_ctz(match);
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i tag2 = _mm_set1_epi64x(tag);
+    for (; way+2 <= NUM_WAY; way += 2) {
+        // SSE2 only compares 32-bit halves, both have to match
+        __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)&tags[way]), tag2);
+        equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+        int match = _mm_movemask_pd(_mm_castsi128_pd(equal));
+        if (match)
+            return way + __builtin_ctz(match);
+    }
+#endif
+    for (; way<NUM_WAY; way++) {
+        if (tags[way] == tag)
             return way;
     }
 
@@ -1033,6 +1213,7 @@ void CACHE::fill_cache(uint32_t set, uint32_t way, PACKET *packet)
     block[set][way].confidence = packet->confidence;
 
     block[set][way].tag = packet->address;
+    update_tag(set, way);
     block[set][way].address = packet->address;
     block[set][way].full_addr = packet->full_addr;
     block[set][way].data = packet->data;
@@ -1058,19 +1239,16 @@ int CACHE::check_hit(PACKET *packet)
     }
 
     // hit
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == packet->address)) {
+    uint32_t way = find_tag(set, packet->address);
+    if (way < NUM_WAY) {
 
-            match_way = way;
+        match_way = way;
 
-            DP ( if (warmup_complete[packet->cpu]) {
-            cout << "[" << NAME << "] " << __func__ << " instr_id: " << packet->instr_id << " type: " << +packet->type << hex << " addr: " << packet->address;
-            cout << " full_addr: " << packet->full_addr << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
-            cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru;
-            cout << " event: " << packet->event_cycle << " cycle: " << current_core_cycle[cpu] << endl; });
-
-            break;
-        }
+        DP ( if (warmup_complete[packet->cpu]) {
+        cout << "[" << NAME << "] " << __func__ << " instr_id: " << packet->instr_id << " type: " << +packet->type << hex << " addr: " << packet->address;
+        cout << " full_addr: " << packet->full_addr << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
+        cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru;
+        cout << " event: " << packet->event_cycle << " cycle: " << current_core_cycle[cpu] << endl; });
     }
 
     return match_way;
@@ -1088,20 +1266,18 @@ int CACHE::invalidate_entry(uint64_t inval_addr)
     }
 
     // invalidate
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == inval_addr)) {
+    uint32_t way = find_tag(set, inval_addr);
+    if (way < NUM_WAY) {
 
-            block[set][way].valid = 0;
+        block[set][way].valid = 0;
+        update_tag(set, way);
 
-            match_way = way;
+        match_way = way;
 
-            DP ( if (warmup_complete[cpu]) {
-            cout << "[" << NAME << "] " << __func__ << " inval_addr: " << hex << inval_addr;  
-            cout << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
-            cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru << " cycle: " << current_core_cycle[cpu] << endl; });
-
-            break;
-        }
+        DP ( if (warmup_complete[cpu]) {
+        cout << "[" << NAME << "] " << __func__ << " inval_addr: " << hex << inval_addr;  
+        cout << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
+        cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru << " cycle: " << current_core_cycle[cpu] << endl; });
     }
 
     return match_way;
@@ -1139,7 +1315,7 @@ int CACHE::add_rq(PACKET *packet)
             DP ( if (warmup_complete[packet->cpu]) {
             cout << "[" << NAME << "_RQ] " << __func__ << " instr_id: " << packet->instr_id << " found recent writebacks";
             cout << hex << " read: " << packet->address << " writeback: " << WQ.entry[wq_index].address << dec;
-            cout << " index: " << MAX_READ << " rob_signal: " << packet->rob_signal << endl; });
+            cout << " index: " << MAX_READ << endl; });
         }
 
         HIT[packet->type]++;
@@ -1157,7 +1333,7 @@ int CACHE::add_rq(PACKET *packet)
         
         if (packet->instruction) {
             uint32_t rob_index = packet->rob_index;
-            RQ.entry[index].rob_index_depend_on_me.insert (rob_index);
+            RQ.entry[index].dependents().rob_index_depend_on_me.insert (rob_index);
             RQ.entry[index].instr_merged = 1;
 
             DP (if (warmup_complete[packet->cpu]) {
@@ -1170,12 +1346,12 @@ int CACHE::add_rq(PACKET *packet)
             if (packet->type == RFO) {
 
                 uint32_t sq_index = packet->sq_index;
-                RQ.entry[index].sq_index_depend_on_me.insert (sq_index);
+                RQ.entry[index].dependents().sq_index_depend_on_me.insert (sq_index);
                 RQ.entry[index].store_merged = 1;
             }
             else {
                 uint32_t lq_index = packet->lq_index; 
-                RQ.entry[index].lq_index_depend_on_me.insert (lq_index);
+                RQ.entry[index].dependents().lq_index_depend_on_me.insert (lq_index);
                 RQ.entry[index].load_merged = 1;
 
                 DP (if (warmup_complete[packet->cpu]) {
@@ -1210,6 +1386,7 @@ int CACHE::add_rq(PACKET *packet)
 #endif
 
     RQ.entry[index] = *packet;
+    RQ.index_entry(index);
 
     // ADD LATENCY
     if (RQ.entry[index].event_cycle < current_core_cycle[packet->cpu])
@@ -1263,6 +1440,7 @@ int CACHE::add_wq(PACKET *packet)
     }
 
     WQ.entry[index] = *packet;
+    WQ.index_entry(index);
 
     // ADD LATENCY
     if (WQ.entry[index].event_cycle < current_core_cycle[packet->cpu])
@@ -1417,6 +1595,7 @@ int CACHE::add_pq(PACKET *packet)
 #endif
 
     PQ.entry[index] = *packet;
+    PQ.index_entry(index);
 
     // ADD LATENCY
     if (PQ.entry[index].event_cycle < current_core_cycle[packet->cpu])
@@ -1471,6 +1650,7 @@ void CACHE::return_data(PACKET *packet)
     else
         MSHR.entry[mshr_index].event_cycle += LATENCY;
 
+    mshr_lookup.update_fill(mshr_index, MSHR.entry[mshr_index].event_cycle);
     update_fill_cycle();
 
     DP (if (warmup_complete[packet->cpu]) {
@@ -1483,24 +1663,10 @@ void CACHE::return_data(PACKET *packet)
 
 void CACHE::update_fill_cycle()
 {
-    // update next_fill_cycle
-    uint64_t min_cycle = UINT64_MAX;
-    uint32_t min_index = MSHR.SIZE;
-    for (uint32_t i=0; i<MSHR.SIZE; i++) {
-        if ((MSHR.entry[i].returned == COMPLETED) && (MSHR.entry[i].event_cycle < min_cycle)) {
-            min_cycle = MSHR.entry[i].event_cycle;
-            min_index = i;
-        }
+    // update next_fill_cycle, the earliest returned entry
+    uint32_t min_index = mshr_lookup.next_fill();
 
-        DP (if (warmup_complete[MSHR.entry[i].cpu]) {
-        cout << "[" << NAME << "_MSHR] " <<  __func__ << " checking instr_id: " << MSHR.entry[i].instr_id;
-        cout << " address: " << hex << MSHR.entry[i].address << " full_addr: " << MSHR.entry[i].full_addr;
-        cout << " data: " << MSHR.entry[i].data << dec << " returned: " << +MSHR.entry[i].returned << " fill_level: " << MSHR.entry[i].fill_level;
-        cout << " index: " << i << " occupancy: " << MSHR.occupancy;
-        cout << " event: " << MSHR.entry[i].event_cycle << " current: " << current_core_cycle[MSHR.entry[i].cpu] << " next: " << MSHR.next_fill_cycle << endl; });
-    }
-    
-    MSHR.next_fill_cycle = min_cycle;
+    MSHR.next_fill_cycle = (min_index < MSHR.SIZE) ? MSHR.entry[min_index].event_cycle : UINT64_MAX;
     MSHR.next_fill_index = min_index;
     if (min_index < MSHR.SIZE) {
 
@@ -1514,17 +1680,27 @@ void CACHE::update_fill_cycle()
 
 int CACHE::check_mshr(PACKET *packet)
 {
-    // search mshr
-    for (uint32_t index=0; index<MSHR_SIZE; index++) {
-        if (MSHR.entry[index].address == packet->address) {
+    // search mshr, only address 0 is not hashed
+    int index = -1;
+    if (packet->address)
+        index = mshr_lookup.find(packet->address);
+    else {
+        for (uint32_t i=0; i<MSHR_SIZE; i++) {
+            if (MSHR.entry[i].address == 0) {
+                index = i;
+                break;
+            }
+        }
+    }
+
+    if (index != -1) {
             
-            DP ( if (warmup_complete[packet->cpu]) {
-            cout << "[" << NAME << "_MSHR] " << __func__ << " same entry instr_id: " << packet->instr_id << " prior_id: " << MSHR.entry[index].instr_id;
-            cout << " address: " << hex << packet->address;
-            cout << " full_addr: " << packet->full_addr << dec << endl; });
+        DP ( if (warmup_complete[packet->cpu]) {
+        cout << "[" << NAME << "_MSHR] " << __func__ << " same entry instr_id: " << packet->instr_id << " prior_id: " << MSHR.entry[index].instr_id;
+        cout << " address: " << hex << packet->address;
+        cout << " full_addr: " << packet->full_addr << dec << endl; });
 
-            return index;
-        }
+        return index;
     }
 
     DP ( if (warmup_complete[packet->cpu]) {
@@ -1543,25 +1719,20 @@ int CACHE::check_mshr(PACKET *packet)
 
 void CACHE::add_mshr(PACKET *packet)
 {
-    uint32_t index = 0;
-
     packet->cycle_enqueued = current_core_cycle[packet->cpu];
 
-    // search mshr
-    for (index=0; index<MSHR_SIZE; index++) {
-        if (MSHR.entry[index].address == 0) {
-            
-            MSHR.entry[index] = *packet;
-            MSHR.entry[index].returned = INFLIGHT;
-            MSHR.occupancy++;
-
-            DP ( if (warmup_complete[packet->cpu]) {
-            cout << "[" << NAME << "_MSHR] " << __func__ << " instr_id: " << packet->instr_id;
-            cout << " address: " << hex << packet->address << " full_addr: " << packet->full_addr << dec;
-            cout << " index: " << index << " occupancy: " << MSHR.occupancy << endl; });
+    // the lowest free entry
+    uint32_t index = mshr_lookup.first_free();
+    if (index < MSHR_SIZE) {
+        MSHR.entry[index] = *packet;
+        MSHR.entry[index].returned = INFLIGHT;
+        MSHR.occupancy++;
+        mshr_lookup.insert(packet->address, index);
 
-            break;
-        }
+        DP ( if (warmup_complete[packet->cpu]) {
+        cout << "[" << NAME << "_MSHR] " << __func__ << " instr_id: " << packet->instr_id;
+        cout << " address: " << hex << packet->address << " full_addr: " << packet->full_addr << dec;
+        cout << " index: " << index << " occupancy: " << MSHR.occupancy << endl; });
     }
 }
 
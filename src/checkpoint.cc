@@ -0,0 +1,258 @@
+#include "checkpoint.h"
+#include "ooo_cpu.h"
+#include "uncore.h"
+#include "component.h"
+
+vector<CHECKPOINT_REGION> &checkpoint_regions()
+{
+    // function-local so that modules can register from their static initializers
+    static vector<CHECKPOINT_REGION> regions;
+
+    return regions;
+}
+
+static bool region_in_use(const CHECKPOINT_REGION &region)
+{
+    return region.component.empty() || selected_components.count(region.component);
+}
+
+static const char *checkpoint_file = "";
+
+static void checkpoint_error(const char *msg)
+{
+    cerr << "[CHECKPOINT] " << checkpoint_file << ": " << msg << endl;
+    assert(0);
+}
+
+static void write_raw(FILE *file, const void *addr, uint64_t size)
+{
+    if (fwrite(addr, 1, size, file) != size)
+        checkpoint_error("write failed");
+}
+
+static void read_raw(FILE *file, void *addr, uint64_t size)
+{
+    if (fread(addr, 1, size, file) != size)
+        checkpoint_error("truncated checkpoint");
+}
+
+template <typename T> static void write_value(FILE *file, T value)
+{
+    write_raw(file, &value, sizeof(T));
+}
+
+template <typename T> static T read_value(FILE *file)
+{
+    T value;
+    read_raw(file, &value, sizeof(T));
+
+    return value;
+}
+
+static void write_string(FILE *file, const string &s)
+{
+    write_value<uint64_t>(file, s.size());
+    write_raw(file, s.data(), s.size());
+}
+
+static string read_string(FILE *file)
+{
+    string s(read_value<uint64_t>(file), '\0');
+    read_raw(file, &s[0], s.size());
+
+    return s;
+}
+
+static void write_map(FILE *file, map<uint64_t, uint64_t> &table)
+{
+    write_value<uint64_t>(file, table.size());
+    for (map<uint64_t, uint64_t>::iterator it = table.begin(); it != table.end(); it++) {
+        write_value<uint64_t>(file, it->first);
+        write_value<uint64_t>(file, it->second);
+    }
+}
+
+static void read_map(FILE *file, map<uint64_t, uint64_t> &table)
+{
+    table.clear();
+
+    uint64_t num_entries = read_value<uint64_t>(file);
+    for (uint64_t i=0; i<num_entries; i++) {
+        uint64_t key = read_value<uint64_t>(file);
+        table.insert(table.end(), make_pair(key, read_value<uint64_t>(file)));
+    }
+}
+
+// every tag array in the system, in a fixed order
+static vector<CACHE *> checkpoint_caches()
+{
+    vector<CACHE *> caches;
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        caches.push_back(&ooo_cpu[i].ITLB);
+        caches.push_back(&ooo_cpu[i].DTLB);
+        caches.push_back(&ooo_cpu[i].STLB);
+        caches.push_back(&ooo_cpu[i].L1I);
+        caches.push_back(&ooo_cpu[i].L1D);
+        caches.push_back(&ooo_cpu[i].L2C);
+    }
+    caches.push_back(&uncore.LLC);
+
+    return caches;
+}
+
+void save_checkpoint(const char *filename)
+{
+    checkpoint_file = filename;
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+        checkpoint_error("cannot open for writing");
+
+    write_value<uint64_t>(file, CHECKPOINT_MAGIC);
+    write_value<uint32_t>(file, CHECKPOINT_VERSION);
+    write_value<uint32_t>(file, NUM_CPUS);
+
+    // retired instructions are also the position of the next instruction in the trace
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        write_value<uint64_t>(file, ooo_cpu[i].num_retired);
+        write_value<uint64_t>(file, current_core_cycle[i]);
+    }
+
+    // tag arrays, including the lru bits
+    vector<CACHE *> caches = checkpoint_caches();
+    for (uint32_t i=0; i<caches.size(); i++) {
+        write_value<uint32_t>(file, caches[i]->NUM_SET);
+        write_value<uint32_t>(file, caches[i]->NUM_WAY);
+        for (uint32_t set=0; set<caches[i]->NUM_SET; set++)
+            write_raw(file, caches[i]->block[set], caches[i]->NUM_WAY*sizeof(BLOCK));
+    }
+
+    // page table
+    write_map(file, page_table);
+    write_map(file, inverse_table);
+    write_map(file, recent_page);
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        write_map(file, unique_cl[i]);
+
+    queue<uint64_t> pages = page_queue;
+    write_value<uint64_t>(file, pages.size());
+    while (pages.size()) {
+        write_value<uint64_t>(file, pages.front());
+        pages.pop();
+    }
+
+    write_value<uint64_t>(file, previous_ppage);
+    write_value<uint64_t>(file, num_adjacent_page);
+    write_value<uint64_t>(file, allocated_pages);
+    write_raw(file, num_cl, sizeof(num_cl));
+    write_raw(file, num_page, sizeof(num_page));
+    write_raw(file, minor_fault, sizeof(minor_fault));
+    write_raw(file, major_fault, sizeof(major_fault));
+
+    ostringstream rand_state;
+    rand_state << champsim_rand.engine;
+    write_string(file, rand_state.str());
+
+    // branch predictor and replacement policy tables
+    vector<CHECKPOINT_REGION> &regions = checkpoint_regions();
+    uint64_t num_regions = 0;
+    for (uint32_t i=0; i<regions.size(); i++)
+        num_regions += region_in_use(regions[i]);
+
+    write_value<uint64_t>(file, num_regions);
+    for (uint32_t i=0; i<regions.size(); i++) {
+        if (!region_in_use(regions[i]))
+            continue;
+
+        write_string(file, regions[i].name);
+        write_value<uint64_t>(file, regions[i].size);
+        write_raw(file, regions[i].addr, regions[i].size);
+    }
+
+    fclose(file);
+}
+
+void load_checkpoint(const char *filename)
+{
+    checkpoint_file = filename;
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+        checkpoint_error("cannot open for reading");
+
+    if (read_value<uint64_t>(file) != CHECKPOINT_MAGIC)
+        checkpoint_error("not a checkpoint");
+    if (read_value<uint32_t>(file) != CHECKPOINT_VERSION)
+        checkpoint_error("unsupported checkpoint version");
+    if (read_value<uint32_t>(file) != NUM_CPUS)
+        checkpoint_error("saved with a different number of cores");
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        ooo_cpu[i].num_retired = read_value<uint64_t>(file);
+        current_core_cycle[i] = read_value<uint64_t>(file);
+    }
+
+    vector<CACHE *> caches = checkpoint_caches();
+    for (uint32_t i=0; i<caches.size(); i++) {
+        uint32_t num_set = read_value<uint32_t>(file),
+                 num_way = read_value<uint32_t>(file);
+        if ((num_set != caches[i]->NUM_SET) || (num_way != caches[i]->NUM_WAY))
+            checkpoint_error("saved with a different cache geometry");
+
+        for (uint32_t set=0; set<caches[i]->NUM_SET; set++) {
+            read_raw(file, caches[i]->block[set], caches[i]->NUM_WAY*sizeof(BLOCK));
+            for (uint32_t way=0; way<caches[i]->NUM_WAY; way++)
+                caches[i]->update_tag(set, way);
+        }
+    }
+
+    read_map(file, page_table);
+    read_map(file, inverse_table);
+    read_map(file, recent_page);
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        read_map(file, unique_cl[i]);
+
+    page_queue = queue<uint64_t>();
+    uint64_t num_pages = read_value<uint64_t>(file);
+    for (uint64_t i=0; i<num_pages; i++)
+        page_queue.push(read_value<uint64_t>(file));
+
+    previous_ppage = read_value<uint64_t>(file);
+    num_adjacent_page = read_value<uint64_t>(file);
+    allocated_pages = read_value<uint64_t>(file);
+    read_raw(file, num_cl, sizeof(num_cl));
+    read_raw(file, num_page, sizeof(num_page));
+    read_raw(file, minor_fault, sizeof(minor_fault));
+    read_raw(file, major_fault, sizeof(major_fault));
+
+    istringstream rand_state(read_string(file));
+    rand_state >> champsim_rand.engine;
+
+    // tables are matched by name, so a checkpoint can be reused after switching to another policy
+    vector<CHECKPOINT_REGION> &regions = checkpoint_regions();
+    vector<uint8_t> restored(regions.size(), 0);
+    uint64_t num_regions = read_value<uint64_t>(file);
+    for (uint64_t i=0; i<num_regions; i++) {
+        string name = read_string(file);
+        uint64_t size = read_value<uint64_t>(file);
+
+        uint32_t match = 0;
+        while ((match < regions.size()) && (!region_in_use(regions[match]) || (regions[match].name != name) || (regions[match].size != size)))
+            match++;
+
+        if (match < regions.size()) {
+            read_raw(file, regions[match].addr, size);
+            restored[match] = 1;
+        }
+        else {
+            cout << "[CHECKPOINT] " << name << " is not used by this run, skipped" << endl;
+            fseek(file, size, SEEK_CUR);
+        }
+    }
+
+    for (uint32_t i=0; i<regions.size(); i++) {
+        if ((restored[i] == 0) && region_in_use(regions[i]))
+            cout << "[CHECKPOINT] " << regions[i].name << " is not in the checkpoint, it starts cold" << endl;
+    }
+
+    fclose(file);
+}
@@ -0,0 +1,47 @@
+#include "component.h"
+
+uint32_t branch_predictor,
+         l1d_prefetcher,
+         l2c_prefetcher,
+         llc_prefetcher,
+         llc_replacement;
+
+set<string> selected_components;
+
+#define COMPONENT_NAME_STRING(ns, name, ...) name,
+
+const char *branch_predictor_names[] = { BRANCH_PREDICTORS(COMPONENT_NAME_STRING, ) },
+           *l1d_prefetcher_names[] = { L1D_PREFETCHERS(COMPONENT_NAME_STRING, ) },
+           *l2c_prefetcher_names[] = { L2C_PREFETCHERS(COMPONENT_NAME_STRING, ) },
+           *llc_prefetcher_names[] = { LLC_PREFETCHERS(COMPONENT_NAME_STRING, ) },
+           *llc_replacement_names[] = { LLC_REPLACEMENTS(COMPONENT_NAME_STRING, ) };
+
+// index of the component called name among the ones of a kind, named after the file extension of its sources
+uint32_t select_component(const char *kind, const char *names[], uint32_t num_components, const char *name)
+{
+    for (uint32_t i=0; i<num_components; i++) {
+        if (string(names[i]) == name) {
+            selected_components.insert(string(name) + "." + kind);
+            return i;
+        }
+    }
+
+    cerr << "[COMPONENT] unknown " << kind << ": " << name << " available:";
+    for (uint32_t i=0; i<num_components; i++)
+        cerr << " " << names[i];
+    cerr << endl;
+    assert(0);
+
+    return 0;
+}
+
+void select_components(const char *bpred, const char *l1d_pref, const char *l2c_pref, const char *llc_pref, const char *llc_repl)
+{
+    selected_components.clear();
+
+    branch_predictor = select_component("bpred", branch_predictor_names, NUM_BRANCH_PREDICTORS, bpred);
+    l1d_prefetcher = select_component("l1d_pref", l1d_prefetcher_names, NUM_L1D_PREFETCHERS, l1d_pref);
+    l2c_prefetcher = select_component("l2c_pref", l2c_prefetcher_names, NUM_L2C_PREFETCHERS, l2c_pref);
+    llc_prefetcher = select_component("llc_pref", llc_prefetcher_names, NUM_LLC_PREFETCHERS, llc_pref);
+    llc_replacement = select_component("llc_repl", llc_replacement_names, NUM_LLC_REPLACEMENTS, llc_repl);
+}
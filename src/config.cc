@@ -0,0 +1,152 @@
+#include <fstream>
+
+#include "config.h"
+
+class CONFIG_VALUE {
+  public:
+    uint32_t *value;
+    double *real;
+};
+
+// every "section.key" that can be set
+static map<string, CONFIG_VALUE> config_values()
+{
+    map<string, CONFIG_VALUE> values;
+
+    values["core.fetch_width"].value = &FETCH_WIDTH;
+    values["core.decode_width"].value = &DECODE_WIDTH;
+    values["core.exec_width"].value = &EXEC_WIDTH;
+    values["core.lq_width"].value = &LQ_WIDTH;
+    values["core.sq_width"].value = &SQ_WIDTH;
+    values["core.retire_width"].value = &RETIRE_WIDTH;
+    values["core.scheduler_size"].value = &SCHEDULER_SIZE;
+    values["core.branch_mispredict_penalty"].value = &BRANCH_MISPREDICT_PENALTY;
+    values["core.rob_size"].value = &core_config.rob_size;
+    values["core.lq_size"].value = &core_config.lq_size;
+    values["core.sq_size"].value = &core_config.sq_size;
+
+    const char *cache_names[] = {"itlb", "dtlb", "stlb", "l1i", "l1d", "l2c", "llc"};
+    CACHE_CONFIG *caches[] = {&itlb_config, &dtlb_config, &stlb_config, &l1i_config, &l1d_config, &l2c_config, &llc_config};
+    for (uint32_t i=0; i<7; i++) {
+        string section = string(cache_names[i]) + ".";
+        values[section + "sets"].value = &caches[i]->sets;
+        values[section + "ways"].value = &caches[i]->ways;
+        values[section + "rq_size"].value = &caches[i]->rq_size;
+        values[section + "wq_size"].value = &caches[i]->wq_size;
+        values[section + "pq_size"].value = &caches[i]->pq_size;
+        values[section + "mshr_size"].value = &caches[i]->mshr_size;
+        values[section + "latency"].value = &caches[i]->latency;
+    }
+
+    values["dram.rq_size"].value = &DRAM_RQ_SIZE;
+    values["dram.wq_size"].value = &DRAM_WQ_SIZE;
+    values["dram.tRP"].real = &tRP_DRAM_NANOSECONDS;
+    values["dram.tRCD"].real = &tRCD_DRAM_NANOSECONDS;
+    values["dram.tCAS"].real = &tCAS_DRAM_NANOSECONDS;
+
+    return values;
+}
+
+static string trim(const string &text)
+{
+    size_t begin = text.find_first_not_of(" \t\r"),
+           end = text.find_last_not_of(" \t\r");
+    if (begin == string::npos)
+        return "";
+
+    return text.substr(begin, end - begin + 1);
+}
+
+static void check_config(const char *filename, const char *name, uint32_t value, uint32_t min, uint32_t max)
+{
+    if ((value < min) || (value > max)) {
+        cerr << "[CONFIG] " << filename << ": " << name << " " << value << " is out of range [" << min << ", " << max << "]" << endl;
+        assert(0);
+    }
+}
+
+void load_config(const char *filename)
+{
+    ifstream file(filename);
+    if (!file.is_open()) {
+        cerr << "[CONFIG] cannot open " << filename << endl;
+        assert(0);
+    }
+
+    map<string, CONFIG_VALUE> values = config_values();
+    string section, line;
+    while (getline(file, line)) {
+        // skip comments and empty lines
+        size_t comment = line.find_first_of("#;");
+        if (comment != string::npos)
+            line.erase(comment);
+        line = trim(line);
+        if (line.empty())
+            continue;
+
+        if (line[0] == '[') {
+            if (line[line.size()-1] != ']') {
+                cerr << "[CONFIG] " << filename << ": bad section \"" << line << "\"" << endl;
+                assert(0);
+            }
+            section = trim(line.substr(1, line.size()-2));
+            continue;
+        }
+
+        size_t equal = line.find('=');
+        string key = (equal == string::npos) ? line : section + "." + trim(line.substr(0, equal));
+        map<string, CONFIG_VALUE>::iterator value = values.find(key);
+        if (value == values.end()) {
+            cerr << "[CONFIG] " << filename << ": unknown setting \"" << line << "\" in section [" << section << "]" << endl;
+            assert(0);
+        }
+
+        istringstream text(line.substr(equal+1));
+        double number;
+        if (!(text >> number) || !(text >> ws).eof() || (number < 0) || (value->second.value && ((number != (uint32_t)number) || (number > UINT32_MAX)))) {
+            cerr << "[CONFIG] " << filename << ": bad value \"" << line << "\"" << endl;
+            assert(0);
+        }
+
+        if (value->second.value)
+            *value->second.value = number;
+        else
+            *value->second.real = number;
+    }
+
+    // the replacement policies and the shadow tag arrays size their tables with LLC_SET and LLC_WAY
+    if ((llc_config.sets != LLC_SET) || (llc_config.ways != LLC_WAY)) {
+        cerr << "[CONFIG] " << filename << ": the LLC geometry is fixed at build time to " << LLC_SET << " sets and " << LLC_WAY << " ways" << endl;
+        assert(0);
+    }
+
+    const char *cache_names[] = {"itlb", "dtlb", "stlb", "l1i", "l1d", "l2c"};
+    CACHE_CONFIG *caches[] = {&itlb_config, &dtlb_config, &stlb_config, &l1i_config, &l1d_config, &l2c_config};
+    for (uint32_t i=0; i<6; i++) {
+        // the set index is taken from the low bits of the address
+        if ((caches[i]->sets == 0) || (caches[i]->sets & (caches[i]->sets - 1))) {
+            cerr << "[CONFIG] " << filename << ": " << cache_names[i] << " sets " << caches[i]->sets << " is not a power of two" << endl;
+            assert(0);
+        }
+        check_config(filename, "ways", caches[i]->ways, 1, UINT32_MAX);
+        check_config(filename, "rq_size", caches[i]->rq_size, 1, UINT32_MAX);
+        check_config(filename, "wq_size", caches[i]->wq_size, 1, UINT32_MAX);
+        check_config(filename, "mshr_size", caches[i]->mshr_size, 1, UINT32_MAX);
+    }
+    check_config(filename, "rq_size", llc_config.rq_size, 1, UINT32_MAX);
+    check_config(filename, "wq_size", llc_config.wq_size, 1, UINT32_MAX);
+    check_config(filename, "mshr_size", llc_config.mshr_size, 1, UINT32_MAX);
+
+    check_config(filename, "fetch_width", FETCH_WIDTH, 1, UINT32_MAX);
+    check_config(filename, "exec_width", EXEC_WIDTH, 1, UINT32_MAX);
+    check_config(filename, "lq_width", LQ_WIDTH, 1, UINT32_MAX);
+    check_config(filename, "sq_width", SQ_WIDTH, 1, UINT32_MAX);
+    check_config(filename, "retire_width", RETIRE_WIDTH, 1, UINT32_MAX);
+    check_config(filename, "scheduler_size", SCHEDULER_SIZE, 1, UINT32_MAX);
+    check_config(filename, "rob_size", core_config.rob_size, 2, MAX_ROB_SIZE);
+    check_config(filename, "lq_size", core_config.lq_size, 2, MAX_LQ_SIZE);
+    check_config(filename, "sq_size", core_config.sq_size, 2, MAX_SQ_SIZE);
+
+    check_config(filename, "rq_size", DRAM_RQ_SIZE, 1, UINT32_MAX);
+    check_config(filename, "wq_size", DRAM_WQ_SIZE, 4, UINT32_MAX);
+}
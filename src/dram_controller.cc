@@ -4,6 +4,9 @@
 uint32_t DRAM_MTPS, DRAM_DBUS_RETURN_TIME,
          tRP, tRCD, tCAS;
 
+uint32_t DRAM_WQ_SIZE = 64, DRAM_RQ_SIZE = 64;
+double tRP_DRAM_NANOSECONDS = 15, tRCD_DRAM_NANOSECONDS = 15, tCAS_DRAM_NANOSECONDS = 12.5;
+
 void print_dram_config()
 {
     cout << "dram_channel_width " << DRAM_CHANNEL_WIDTH << endl
@@ -137,6 +140,65 @@ void MEMORY_CONTROLLER::operate()
     }
 }
 
+// earliest cycle at which operate() could do any work if no new request arrives
+uint64_t MEMORY_CONTROLLER::get_next_event_cycle()
+{
+    uint64_t next_event = UINT64_MAX;
+
+    for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
+        uint64_t next_cycle = current_core_cycle[0] + 1, queue_event;
+
+        // read/write mode switch
+        if (write_mode[i] == 0) {
+            if ((WQ[i].occupancy >= DRAM_WRITE_HIGH_WM) || ((RQ[i].occupancy == 0) && (WQ[i].occupancy > 0)))
+                return next_cycle;
+            queue_event = get_next_queue_event(&RQ[i], next_cycle);
+        }
+        else {
+            if ((WQ[i].occupancy == 0) || (RQ[i].occupancy && (WQ[i].occupancy < DRAM_WRITE_LOW_WM)))
+                return next_cycle;
+            queue_event = get_next_queue_event(&WQ[i], next_cycle);
+        }
+
+        if (queue_event < next_event)
+            next_event = queue_event;
+    }
+
+    return next_event;
+}
+
+uint64_t MEMORY_CONTROLLER::get_next_queue_event(PACKET_QUEUE *queue, uint64_t cycle)
+{
+    uint64_t next_event = UINT64_MAX;
+
+    // schedule() can only pick a request whose bank is idle, and banks are released by process()
+    if (queue->next_schedule_index < queue->SIZE) {
+        if (queue->next_schedule_cycle > cycle)
+            next_event = queue->next_schedule_cycle;
+        else {
+            for (uint32_t i=0; i<queue->SIZE; i++) {
+                if (queue->entry[i].address && (queue->entry[i].scheduled == 0)) {
+                    uint64_t addr = queue->entry[i].address;
+                    if (bank_request[dram_get_channel(addr)][dram_get_rank(addr)][dram_get_bank(addr)].working == 0)
+                        return cycle;
+                }
+            }
+        }
+    }
+
+    // process() waits for both the request and its bank
+    if (queue->next_process_index < queue->SIZE) {
+        uint64_t addr = queue->entry[queue->next_process_index].address,
+                 process_cycle = bank_request[dram_get_channel(addr)][dram_get_rank(addr)][dram_get_bank(addr)].cycle_available;
+        if (queue->next_process_cycle > process_cycle)
+            process_cycle = queue->next_process_cycle;
+        if (process_cycle < next_event)
+            next_event = process_cycle;
+    }
+
+    return next_event;
+}
+
 void MEMORY_CONTROLLER::schedule(PACKET_QUEUE *queue)
 {
     uint64_t read_addr;
@@ -477,7 +539,7 @@ int MEMORY_CONTROLLER::add_rq(PACKET *packet)
         return index; // merged index
 
     // search for the empty index
-    for (index=0; index<DRAM_RQ_SIZE; index++) {
+    for (index=0; index<(int)DRAM_RQ_SIZE; index++) {
         if (RQ[channel].entry[index].address == 0) {
             
             RQ[channel].entry[index] = *packet;
@@ -519,7 +581,7 @@ int MEMORY_CONTROLLER::add_wq(PACKET *packet)
         return index; // merged index
 
     // search for the empty index
-    for (index=0; index<DRAM_WQ_SIZE; index++) {
+    for (index=0; index<(int)DRAM_WQ_SIZE; index++) {
         if (WQ[channel].entry[index].address == 0) {
             
             WQ[channel].entry[index] = *packet;
@@ -719,3 +781,19 @@ void MEMORY_CONTROLLER::increment_WQ_FULL(uint64_t address)
     uint32_t channel = dram_get_channel(address);
     WQ[channel].FULL++;
 }
+
+void MEMORY_CONTROLLER::functional_access(PACKET *packet)
+{
+    // dram has no state that needs to be warmed up
+}
+
+// called before the simulation starts
+void MEMORY_CONTROLLER::configure()
+{
+    for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
+        if (WQ[i].SIZE != DRAM_WQ_SIZE)
+            WQ[i].resize(DRAM_WQ_SIZE);
+        if (RQ[i].SIZE != DRAM_RQ_SIZE)
+            RQ[i].resize(DRAM_RQ_SIZE);
+    }
+}
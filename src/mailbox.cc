@@ -0,0 +1,108 @@
+#include "mailbox.h"
+
+void MAILBOX::begin_quantum()
+{
+    // the shared level does not drain while the core runs ahead, so start from its current occupancy
+    // plus whatever this core could not hand over yet
+    for (uint32_t i=0; i<4; i++)
+        occupancy[i] = shared_level->get_occupancy(i, 0);
+
+    for (uint32_t i=0; i<pending.size(); i++) {
+        if (pending[i].queue_type)
+            occupancy[pending[i].queue_type]++;
+    }
+}
+
+void MAILBOX::add_request(uint8_t queue_type, PACKET *packet)
+{
+    MAILBOX_ENTRY request;
+    request.cycle = current_core_cycle[cpu];
+    request.queue_type = queue_type;
+    request.packet = *packet;
+
+    pending.push_back(request);
+    if (queue_type)
+        occupancy[queue_type]++;
+}
+
+int MAILBOX::add_rq(PACKET *packet)
+{
+    add_request(1, packet);
+
+    return -1;
+}
+
+int MAILBOX::add_wq(PACKET *packet)
+{
+    add_request(2, packet);
+
+    return -1;
+}
+
+int MAILBOX::add_pq(PACKET *packet)
+{
+    add_request(3, packet);
+
+    return -1;
+}
+
+void MAILBOX::increment_WQ_FULL(uint64_t address)
+{
+    PACKET packet;
+    packet.address = address;
+
+    add_request(0, &packet);
+}
+
+void MAILBOX::return_data(PACKET *packet)
+{
+    // data always comes back from the shared level straight to the L2C
+    cerr << "[MAILBOX] " << __func__ << " cpu: " << cpu << " instr_id: " << packet->instr_id << " unexpected return" << endl;
+    assert(0);
+}
+
+void MAILBOX::operate()
+{
+
+}
+
+uint32_t MAILBOX::get_occupancy(uint8_t queue_type, uint64_t address)
+{
+    uint32_t size = shared_level->get_size(queue_type, address);
+
+    return (occupancy[queue_type] < size) ? occupancy[queue_type] : size;
+}
+
+uint32_t MAILBOX::get_size(uint8_t queue_type, uint64_t address)
+{
+    return shared_level->get_size(queue_type, address);
+}
+
+void MAILBOX::functional_access(PACKET *packet)
+{
+    shared_level->functional_access(packet);
+}
+
+void MAILBOX::deliver(uint64_t cycle)
+{
+    while (pending.size() && (pending.front().cycle <= cycle)) {
+        MAILBOX_ENTRY &request = pending.front();
+
+        if (request.queue_type == 0)
+            shared_level->increment_WQ_FULL(request.packet.address);
+        else {
+            // a full queue holds back the rest of this core's requests until the next cycle
+            if (shared_level->get_occupancy(request.queue_type, request.packet.address) == shared_level->get_size(request.queue_type, request.packet.address))
+                return;
+
+            if (request.queue_type == 1)
+                shared_level->add_rq(&request.packet);
+            else if (request.queue_type == 2)
+                shared_level->add_wq(&request.packet);
+            else
+                shared_level->add_pq(&request.packet);
+        }
+
+        pending.pop_front();
+    }
+}
@@ -3,7 +3,14 @@
 #include <getopt.h>
 #include "ooo_cpu.h"
 #include "uncore.h"
+#include "parallel.h"
+#include "mailbox.h"
+#include "checkpoint.h"
+#include "simpoint.h"
+#include "shadow_llc.h"
+#include "config.h"
 #include <fstream>
+#include <mutex>
 
 #define FIXED_FLOAT(x) std::fixed << std::setprecision(5) << (x)
 
@@ -13,16 +20,45 @@ uint8_t warmup_complete[NUM_CPUS],
         all_simulation_complete = 0,
         MAX_INSTR_DESTINATIONS = NUM_INSTR_DESTINATIONS,
         knob_cloudsuite = 0,
-        knob_low_bandwidth = 0;
+        knob_low_bandwidth = 0,
+        knob_event_skip = 0,
+        show_heartbeat = 1;
+
+uint32_t knob_threads = 1,
+         knob_sync_quantum = 0;
 
 uint64_t warmup_instructions     = 1000000,
          simulation_instructions = 10000000,
+         fast_forward_instructions = 0,
          champsim_seed;
 
+const char *save_checkpoint_file = NULL,
+           *load_checkpoint_file = NULL,
+           *simpoint_file = NULL,
+           *llc_shadow_policies = NULL,
+           *config_file = NULL,
+           *trace_cache_dir = NULL;
+
+// components, every one is compiled in and selected by name
+const char *knob_bpred = "bimodal",
+           *knob_l1d_pref = "no",
+           *knob_l2c_pref = "no",
+           *knob_llc_pref = "no",
+           *knob_llc_repl = "lru";
+
+// SIMPOINT
+vector<SIMPOINT> simpoints;
+uint32_t current_simpoint = 0;
+uint8_t simpoint_draining = 0;
+uint64_t simpoint_warmup = 0;
+double simpoint_instr = 0, simpoint_cycle = 0, simpoint_branch = 0, simpoint_mispredictions = 0, simpoint_rob_occupancy = 0;
+SIMPOINT_CACHE_STATS simpoint_l1d, simpoint_l1i, simpoint_l2c, simpoint_llc;
+
 time_t start_time;
 
 // PAGE TABLE
 uint32_t PAGE_TABLE_LATENCY = 0, SWAP_LATENCY = 0;
+std::mutex page_table_mutex;
 queue <uint64_t > page_queue;
 map <uint64_t, uint64_t> page_table, inverse_table, recent_page, unique_cl[NUM_CPUS];
 uint64_t previous_ppage, num_adjacent_page, num_cl[NUM_CPUS], allocated_pages, num_page[NUM_CPUS], minor_fault[NUM_CPUS], major_fault[NUM_CPUS];
@@ -70,6 +106,26 @@ void print_roi_stats(uint32_t cpu, CACHE *cache)
         << endl;
 }
 
+void print_shadow_llc_stats(uint32_t cpu)
+{
+    for (uint32_t i=0; i<shadow_llcs.size(); i++) {
+        SHADOW_LLC *shadow = shadow_llcs[i];
+        uint64_t TOTAL_ACCESS = 0, TOTAL_HIT = 0, TOTAL_MISS = 0;
+
+        for (uint32_t j=0; j<NUM_TYPES; j++) {
+            TOTAL_ACCESS += shadow->roi_access[cpu][j];
+            TOTAL_HIT += shadow->roi_hit[cpu][j];
+            TOTAL_MISS += shadow->roi_miss[cpu][j];
+        }
+
+        cout<< "Core_" << cpu << "_LLC_shadow_" << shadow->NAME << "_total_access " << TOTAL_ACCESS << endl
+            << "Core_" << cpu << "_LLC_shadow_" << shadow->NAME << "_total_hit " << TOTAL_HIT << endl
+            << "Core_" << cpu << "_LLC_shadow_" << shadow->NAME << "_total_miss " << TOTAL_MISS << endl
+            << "Core_" << cpu << "_LLC_shadow_" << shadow->NAME << "_MPKI " << (1000.0*TOTAL_MISS)/ooo_cpu[cpu].finish_sim_instr << endl
+            << endl;
+    }
+}
+
 void print_sim_stats(uint32_t cpu, CACHE *cache)
 {
     uint64_t TOTAL_ACCESS = 0, TOTAL_HIT = 0, TOTAL_MISS = 0;
@@ -190,6 +246,9 @@ void finish_warmup()
         reset_cache_stats(i, &ooo_cpu[i].L1D);
         reset_cache_stats(i, &ooo_cpu[i].L2C);
         reset_cache_stats(i, &uncore.LLC);
+
+        for (uint32_t j=0; j<shadow_llcs.size(); j++)
+            shadow_llcs[j]->reset_stats(i);
     }
     cout << endl;
 
@@ -203,14 +262,50 @@ void finish_warmup()
 
     // set actual cache latency
     for (uint32_t i=0; i<NUM_CPUS; i++) {
-        ooo_cpu[i].ITLB.LATENCY = ITLB_LATENCY;
-        ooo_cpu[i].DTLB.LATENCY = DTLB_LATENCY;
-        ooo_cpu[i].STLB.LATENCY = STLB_LATENCY;
-        ooo_cpu[i].L1I.LATENCY  = L1I_LATENCY;
-        ooo_cpu[i].L1D.LATENCY  = L1D_LATENCY;
-        ooo_cpu[i].L2C.LATENCY  = L2C_LATENCY;
+        ooo_cpu[i].ITLB.LATENCY = itlb_config.latency;
+        ooo_cpu[i].DTLB.LATENCY = dtlb_config.latency;
+        ooo_cpu[i].STLB.LATENCY = stlb_config.latency;
+        ooo_cpu[i].L1I.LATENCY  = l1i_config.latency;
+        ooo_cpu[i].L1D.LATENCY  = l1d_config.latency;
+        ooo_cpu[i].L2C.LATENCY  = l2c_config.latency;
+    }
+    uncore.LLC.LATENCY = llc_config.latency;
+
+    if (save_checkpoint_file) {
+        save_checkpoint(save_checkpoint_file);
+        cout << "Checkpoint saved: " << save_checkpoint_file << endl << endl;
     }
-    uncore.LLC.LATENCY = LLC_LATENCY;
+}
+
+// when no core, cache or DRAM channel can make progress before a future cycle,
+// jump all core clocks to the cycle right before it instead of simulating idle cycles one by one
+void skip_idle_cycles()
+{
+    uint64_t next_cycle = current_core_cycle[0] + 1,
+             next_event = uncore.DRAM.get_next_event_cycle();
+    if (next_event <= next_cycle)
+        return;
+
+    uint64_t event = uncore.LLC.get_next_event_cycle();
+    if (event <= next_cycle)
+        return;
+    if (event < next_event)
+        next_event = event;
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        event = ooo_cpu[i].get_next_event_cycle();
+        if (event <= next_cycle)
+            return;
+        if (event < next_event)
+            next_event = event;
+    }
+
+    // nothing is pending at all
+    if (next_event == UINT64_MAX)
+        return;
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        current_core_cycle[i] = next_event - 1;
 }
 
 void print_deadlock(uint32_t i)
@@ -226,13 +321,13 @@ void print_deadlock(uint32_t i)
 
     // print LQ entry
     cout << endl << "Load Queue Entry" << endl;
-    for (uint32_t j=0; j<LQ_SIZE; j++) {
+    for (uint32_t j=0; j<ooo_cpu[i].LQ.SIZE; j++) {
         cout << "[LQ] entry: " << j << " instr_id: " << ooo_cpu[i].LQ.entry[j].instr_id << " address: " << hex << ooo_cpu[i].LQ.entry[j].physical_address << dec << " translated: " << +ooo_cpu[i].LQ.entry[j].translated << " fetched: " << +ooo_cpu[i].LQ.entry[i].fetched << endl;
     }
 
     // print SQ entry
     cout << endl << "Store Queue Entry" << endl;
-    for (uint32_t j=0; j<SQ_SIZE; j++) {
+    for (uint32_t j=0; j<ooo_cpu[i].SQ.SIZE; j++) {
         cout << "[SQ] entry: " << j << " instr_id: " << ooo_cpu[i].SQ.entry[j].instr_id << " address: " << hex << ooo_cpu[i].SQ.entry[j].physical_address << dec << " translated: " << +ooo_cpu[i].SQ.entry[j].translated << " fetched: " << +ooo_cpu[i].SQ.entry[i].fetched << endl;
     }
 
@@ -249,6 +344,367 @@ void print_deadlock(uint32_t i)
     assert(0);
 }
 
+// the parallel engine splits each core cycle at the first access to state shared between cores:
+// STLB misses walk the page table and L2C misses go to the LLC, so that part runs serially in core order
+#define CORE_PHASE_FRONT   0
+#define CORE_PHASE_BACK    1
+#define CORE_PHASE_QUANTUM 2
+
+PARALLEL_ENGINE core_threads;
+uint8_t core_active[NUM_CPUS];
+
+// with -sync_quantum each L2C talks to the LLC through its own mailbox
+MAILBOX llc_mailbox[NUM_CPUS];
+
+void print_simulation_time(ostream &out)
+{
+    uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
+             elapsed_minute = elapsed_second / 60,
+             elapsed_hour = elapsed_minute / 60;
+    elapsed_minute -= elapsed_hour*60;
+    elapsed_second -= (elapsed_hour*3600 + elapsed_minute*60);
+
+    out << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
+}
+
+void print_heartbeat(uint32_t i, ostream &out)
+{
+    float cumulative_ipc;
+    if (warmup_complete[i])
+        cumulative_ipc = (1.0*(ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr)) / (current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle);
+    else
+        cumulative_ipc = (1.0*ooo_cpu[i].num_retired) / current_core_cycle[i];
+    float heartbeat_ipc = (1.0*ooo_cpu[i].num_retired - ooo_cpu[i].last_sim_instr) / (current_core_cycle[i] - ooo_cpu[i].last_sim_cycle);
+
+    out << "Heartbeat CPU " << setw(2) << i << " instructions: " << setw(10) << ooo_cpu[i].num_retired << " cycles: " << setw(10) << current_core_cycle[i];
+    out << " heartbeat IPC: " << FIXED_FLOAT(heartbeat_ipc) << " cumulative IPC: " << FIXED_FLOAT(cumulative_ipc); 
+    print_simulation_time(out);
+    ooo_cpu[i].next_print_instruction += STAT_PRINTING_PERIOD;
+
+    ooo_cpu[i].last_sim_instr = ooo_cpu[i].num_retired;
+    ooo_cpu[i].last_sim_cycle = current_core_cycle[i];
+}
+
+void finish_simulation(uint32_t i, ostream &out)
+{
+    simulation_complete[i] = 1;
+    ooo_cpu[i].finish_sim_instr = ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr;
+    ooo_cpu[i].finish_sim_cycle = current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle;
+
+    out << "Finished CPU " << i << " instructions: " << ooo_cpu[i].finish_sim_instr << " cycles: " << ooo_cpu[i].finish_sim_cycle;
+    out << " cumulative IPC: " << ((float) ooo_cpu[i].finish_sim_instr / ooo_cpu[i].finish_sim_cycle);
+    print_simulation_time(out);
+
+    record_roi_stats(i, &ooo_cpu[i].L1D);
+    record_roi_stats(i, &ooo_cpu[i].L1I);
+    record_roi_stats(i, &ooo_cpu[i].L2C);
+    record_roi_stats(i, &uncore.LLC);
+
+    for (uint32_t j=0; j<shadow_llcs.size(); j++)
+        shadow_llcs[j]->record_roi_stats(i);
+}
+
+void flush_core_output(uint32_t i)
+{
+    if (ooo_cpu[i].deferred_output.tellp() > 0) {
+        cout << ooo_cpu[i].deferred_output.str() << flush;
+        ooo_cpu[i].deferred_output.str("");
+    }
+}
+
+void operate_core_front(uint32_t i)
+{
+    // fetch unit
+    if (ooo_cpu[i].ROB.occupancy < ooo_cpu[i].ROB.SIZE) {
+        // handle branch
+        if ((ooo_cpu[i].fetch_stall == 0) && (simpoint_draining == 0))
+            ooo_cpu[i].handle_branch();
+    }
+
+    // fetch
+    ooo_cpu[i].fetch_instruction();
+
+
+    // schedule (including decode latency)
+    uint32_t schedule_index = ooo_cpu[i].ROB.next_schedule;
+    if ((ooo_cpu[i].ROB.entry[schedule_index].scheduled == 0) && (ooo_cpu[i].ROB.entry[schedule_index].event_cycle <= current_core_cycle[i]))
+        ooo_cpu[i].schedule_instruction();
+
+    // execute
+    ooo_cpu[i].execute_instruction();
+
+    // memory operation
+    ooo_cpu[i].schedule_memory_instruction();
+    ooo_cpu[i].operate_lsq();
+    ooo_cpu[i].ITLB.operate();
+    ooo_cpu[i].DTLB.operate();
+}
+
+void operate_core_shared(uint32_t i)
+{
+    ooo_cpu[i].STLB.operate();
+    ooo_cpu[i].L1I.operate();
+    ooo_cpu[i].L1D.operate();
+    ooo_cpu[i].L2C.operate();
+}
+
+void operate_core_back(uint32_t i)
+{
+    // complete 
+    ooo_cpu[i].update_rob();
+
+    // retire
+    if ((ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].executed == COMPLETED) && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle <= current_core_cycle[i]))
+        ooo_cpu[i].retire_rob();
+}
+
+// per-core part of the per-cycle checks in the main loop. the steps that touch every core
+// (finishing the warmup, ending the simulation) are left to simulate_quantum
+void check_core_quantum(uint32_t i)
+{
+    // heartbeat information
+    if (show_heartbeat && (ooo_cpu[i].num_retired >= ooo_cpu[i].next_print_instruction))
+        print_heartbeat(i, ooo_cpu[i].deferred_output);
+
+    // check for deadlock
+    if (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].ip && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle + DEADLOCK_CYCLE) <= current_core_cycle[i])
+        print_deadlock(i);
+
+    // check for warmup
+    if ((warmup_complete[i] == 0) && (ooo_cpu[i].num_retired > warmup_instructions))
+        warmup_complete[i] = 1;
+
+    // simulation complete
+    if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && (ooo_cpu[i].num_retired >= (ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions)))
+        finish_simulation(i, ooo_cpu[i].deferred_output);
+}
+
+void run_core_quantum(uint32_t i)
+{
+    for (uint32_t n=0; n<knob_sync_quantum; n++) {
+        // proceed one cycle
+        current_core_cycle[i]++;
+
+        // core might be stalled due to page fault or branch misprediction
+        if (stall_cycle[i] <= current_core_cycle[i]) {
+            operate_core_front(i);
+            operate_core_shared(i);
+            operate_core_back(i);
+        }
+
+        check_core_quantum(i);
+    }
+}
+
+void operate_core_phase(uint32_t cpu, uint32_t phase)
+{
+    if (core_active[cpu] == 0)
+        return;
+
+    if (phase == CORE_PHASE_QUANTUM)
+        run_core_quantum(cpu);
+    else if (phase == CORE_PHASE_FRONT)
+        operate_core_front(cpu);
+    else
+        operate_core_back(cpu);
+}
+
+// every core runs knob_sync_quantum cycles on its own, sending its LLC requests to its mailbox.
+// the uncore then replays the same cycles and takes the requests in cycle order, so an LLC
+// response reaches the L2C up to one quantum late. returns 0 once all cores are done
+uint8_t simulate_quantum()
+{
+    uint64_t begin_cycle = current_core_cycle[0];
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        llc_mailbox[i].begin_quantum();
+
+    // like the main loop, the warmup finishes right after the last core to reach it has run,
+    // before the cores behind it (already warm) and the uncore run. so those cores wait for the check
+    uint32_t warm_from = 0;
+    if (all_warmup_complete <= NUM_CPUS) {
+        for (uint32_t i=0; i<NUM_CPUS; i++) {
+            if (warmup_complete[i] == 0)
+                warm_from = i+1;
+        }
+    }
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        core_active[i] = (i < warm_from);
+    if (warm_from)
+        core_threads.run(CORE_PHASE_QUANTUM);
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        flush_core_output(i);
+
+    // warmup complete
+    if (all_warmup_complete <= NUM_CPUS) {
+        all_warmup_complete = 0;
+        for (uint32_t i=0; i<NUM_CPUS; i++)
+            all_warmup_complete += warmup_complete[i];
+
+        if (all_warmup_complete == NUM_CPUS) {
+            all_warmup_complete++;
+            finish_warmup();
+        }
+    }
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        core_active[i] = (i >= warm_from);
+    if (warm_from < NUM_CPUS)
+        core_threads.run(CORE_PHASE_QUANTUM);
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        flush_core_output(i);
+
+    for (uint64_t cycle=begin_cycle+1; cycle<=(begin_cycle+knob_sync_quantum); cycle++) {
+        for (uint32_t i=0; i<NUM_CPUS; i++)
+            current_core_cycle[i] = cycle;
+
+        for (uint32_t i=0; i<NUM_CPUS; i++)
+            llc_mailbox[i].deliver(cycle);
+
+        uncore.LLC.operate();
+        uncore.DRAM.operate();
+    }
+
+    all_simulation_complete = 0;
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        all_simulation_complete += simulation_complete[i];
+
+    return (all_simulation_complete < NUM_CPUS);
+}
+
+uint8_t memory_idle(uint32_t cpu)
+{
+    CACHE *caches[] = {&ooo_cpu[cpu].ITLB, &ooo_cpu[cpu].DTLB, &ooo_cpu[cpu].STLB, &ooo_cpu[cpu].L1I, &ooo_cpu[cpu].L1D, &ooo_cpu[cpu].L2C, &uncore.LLC};
+
+    for (uint32_t i=0; i<(sizeof(caches)/sizeof(caches[0])); i++) {
+        if (caches[i]->RQ.occupancy || caches[i]->WQ.occupancy || caches[i]->PQ.occupancy || caches[i]->MSHR.occupancy)
+            return 0;
+    }
+
+    return 1;
+}
+
+// fast-forward to the detailed warmup of the current region and arm its warmup and ROI
+// with -simpoints there is a single core and its pipeline is empty here, so every instruction read so far has retired
+void begin_simpoint()
+{
+    SIMPOINT &simpoint = simpoints[current_simpoint];
+    uint64_t warmup_start = (simpoint.start > simpoint_warmup) ? (simpoint.start - simpoint_warmup) : 0,
+             fast_forward = 0;
+
+    while (ooo_cpu[0].instr_unique_id < warmup_start) {
+        ooo_cpu[0].fast_forward_instruction();
+        fast_forward++;
+    }
+    stall_cycle[0] = 0;
+
+    cout << "SimPoint " << current_simpoint << " start: " << simpoint.start << " length: " << simpoint.length << " weight: " << simpoint.weight;
+    cout << " fast-forward: " << fast_forward << endl;
+
+    // back-to-back regions lose the few instructions that were still in flight when the previous one ended
+    uint64_t warmup = (simpoint.start > ooo_cpu[0].instr_unique_id) ? (simpoint.start - ooo_cpu[0].instr_unique_id) : 0;
+    warmup_instructions = ooo_cpu[0].num_retired + warmup;
+    ooo_cpu[0].simulation_instructions = simpoint.length;
+
+    warmup_complete[0] = 0;
+    all_warmup_complete = 0;
+    simulation_complete[0] = 0;
+    all_simulation_complete = 0;
+}
+
+// called every cycle after the ROI of the current region, returns 0 once all regions are simulated
+uint8_t simpoint_step()
+{
+    if (simpoint_draining == 0) {
+        double weight = simpoints[current_simpoint].weight;
+
+        simpoint_instr += weight * ooo_cpu[0].finish_sim_instr;
+        simpoint_cycle += weight * ooo_cpu[0].finish_sim_cycle;
+        simpoint_branch += weight * ooo_cpu[0].num_branch;
+        simpoint_mispredictions += weight * ooo_cpu[0].branch_mispredictions;
+        simpoint_rob_occupancy += weight * ooo_cpu[0].total_rob_occupancy_at_branch_mispredict;
+
+        simpoint_l1d.add(0, &ooo_cpu[0].L1D, weight);
+        simpoint_l1i.add(0, &ooo_cpu[0].L1I, weight);
+        simpoint_l2c.add(0, &ooo_cpu[0].L2C, weight);
+        simpoint_llc.add(0, &uncore.LLC, weight);
+
+        simpoint_draining = 1;
+    }
+
+    if ((current_simpoint + 1) < simpoints.size()) {
+        // no new instructions are fetched until the in-flight ones retire and the caches settle
+        if (ooo_cpu[0].ROB.occupancy || (memory_idle(0) == 0))
+            return 1;
+
+        simpoint_draining = 0;
+        current_simpoint++;
+        begin_simpoint();
+
+        return 1;
+    }
+
+    // the ROI statistics become the weighted totals over all regions
+    ooo_cpu[0].finish_sim_instr = (uint64_t) (simpoint_instr + 0.5);
+    ooo_cpu[0].finish_sim_cycle = (uint64_t) (simpoint_cycle + 0.5);
+    ooo_cpu[0].num_branch = (uint64_t) (simpoint_branch + 0.5);
+    ooo_cpu[0].branch_mispredictions = (uint64_t) (simpoint_mispredictions + 0.5);
+    ooo_cpu[0].total_rob_occupancy_at_branch_mispredict = (uint64_t) (simpoint_rob_occupancy + 0.5);
+    ooo_cpu[0].warmup_instructions = ooo_cpu[0].num_retired - ooo_cpu[0].finish_sim_instr; // branch MPKI is per ROI instruction
+
+    simpoint_l1d.apply(0, &ooo_cpu[0].L1D);
+    simpoint_l1i.apply(0, &ooo_cpu[0].L1I);
+    simpoint_l2c.apply(0, &ooo_cpu[0].L2C);
+    simpoint_llc.apply(0, &uncore.LLC);
+
+    cout << endl << "Weighted " << simpoints.size() << " SimPoints instructions: " << ooo_cpu[0].finish_sim_instr << " cycles: " << ooo_cpu[0].finish_sim_cycle;
+    cout << " cumulative IPC: " << ((float) ooo_cpu[0].finish_sim_instr / ooo_cpu[0].finish_sim_cycle) << endl;
+
+    return 0;
+}
+
+// heartbeats, warmup and simulation completion print or reset the state of every core,
+// so a cycle in which any core might reach one of them is simulated serially
+uint8_t parallel_cycle_allowed()
+{
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        uint64_t max_retired = ooo_cpu[i].num_retired + RETIRE_WIDTH;
+
+        if (show_heartbeat && (max_retired >= ooo_cpu[i].next_print_instruction))
+            return 0;
+        if ((warmup_complete[i] == 0) && (max_retired > warmup_instructions))
+            return 0;
+        if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && (max_retired >= (ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions)))
+            return 0;
+    }
+
+    return 1;
+}
+
+void operate_cores_parallel()
+{
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        current_core_cycle[i]++;
+
+        // core might be stalled due to page fault or branch misprediction
+        core_active[i] = (stall_cycle[i] <= current_core_cycle[i]);
+    }
+
+    core_threads.run(CORE_PHASE_FRONT);
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        if (core_active[i]) {
+            flush_core_output(i);
+            operate_core_shared(i);
+        }
+    }
+
+    core_threads.run(CORE_PHASE_BACK);
+}
+
 void signal_handler(int signal) 
 {
 	cout << "Caught signal: " << signal << endl;
@@ -287,6 +743,9 @@ uint64_t rotr64 (uint64_t n, unsigned int c)
 RANDOM champsim_rand(champsim_seed);
 uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_vpage)
 {
+    // with -sync_quantum, STLB misses of different cores may walk the page table at the same time
+    std::lock_guard<std::mutex> page_table_lock(page_table_mutex);
+
 #ifdef SANITY_CHECK
     if (va == 0) 
         assert(0);
@@ -510,7 +969,6 @@ int main(int argc, char** argv)
          << "*************************************************" << endl;
 
     // initialize knobs
-    uint8_t show_heartbeat = 1;
 
     uint32_t seed_number = 0;
 
@@ -524,6 +982,21 @@ int main(int argc, char** argv)
             {"hide_heartbeat", no_argument, 0, 'h'},
             {"cloudsuite", no_argument, 0, 'c'},
             {"low_bandwidth",  no_argument, 0, 'b'},
+            {"event_skip",  no_argument, 0, 'e'},
+            {"threads", required_argument, 0, 'n'},
+            {"sync_quantum", required_argument, 0, 'q'},
+            {"fast_forward", required_argument, 0, 'f'},
+            {"save_checkpoint", required_argument, 0, 'v'},
+            {"load_checkpoint", required_argument, 0, 'l'},
+            {"simpoints", required_argument, 0, 'p'},
+            {"llc_shadow", required_argument, 0, 'r'},
+            {"bpred", required_argument, 0, 'B'},
+            {"l1d_pref", required_argument, 0, 'D'},
+            {"l2c_pref", required_argument, 0, 'L'},
+            {"llc_pref", required_argument, 0, 'P'},
+            {"llc_repl", required_argument, 0, 'R'},
+            {"config", required_argument, 0, 'g'},
+            {"trace_cache", required_argument, 0, 'T'},
             {"traces",  no_argument, 0, 't'},
             {0, 0, 0, 0}      
         };
@@ -555,6 +1028,51 @@ int main(int argc, char** argv)
             case 'b':
                 knob_low_bandwidth = 1;
                 break;
+            case 'e':
+                knob_event_skip = 1;
+                break;
+            case 'n':
+                knob_threads = atol(optarg);
+                break;
+            case 'q':
+                knob_sync_quantum = atol(optarg);
+                break;
+            case 'f':
+                fast_forward_instructions = atol(optarg);
+                break;
+            case 'v':
+                save_checkpoint_file = optarg;
+                break;
+            case 'l':
+                load_checkpoint_file = optarg;
+                break;
+            case 'p':
+                simpoint_file = optarg;
+                break;
+            case 'r':
+                llc_shadow_policies = optarg;
+                break;
+            case 'B':
+                knob_bpred = optarg;
+                break;
+            case 'D':
+                knob_l1d_pref = optarg;
+                break;
+            case 'L':
+                knob_l2c_pref = optarg;
+                break;
+            case 'P':
+                knob_llc_pref = optarg;
+                break;
+            case 'R':
+                knob_llc_repl = optarg;
+                break;
+            case 'g':
+                config_file = optarg;
+                break;
+            case 'T':
+                trace_cache_dir = optarg;
+                break;
             case 't':
                 traces_encountered = 1;
                 break;
@@ -566,6 +1084,43 @@ int main(int argc, char** argv)
             break;
     }
 
+    // a loaded checkpoint is already warmed up
+    if (load_checkpoint_file && (save_checkpoint_file || fast_forward_instructions)) {
+        cerr << "-load_checkpoint cannot be combined with -save_checkpoint or -fast_forward" << endl;
+        assert(0);
+    }
+
+    // regions are sequenced on the serial engine of a single core
+    if (simpoint_file) {
+        if ((NUM_CPUS > 1) || knob_sync_quantum || fast_forward_instructions || load_checkpoint_file || save_checkpoint_file) {
+            cerr << "-simpoints needs a single-core binary and cannot be combined with -sync_quantum, -fast_forward or checkpoints" << endl;
+            assert(0);
+        }
+        simpoints = read_simpoints(simpoint_file);
+    }
+
+    select_components(knob_bpred, knob_l1d_pref, knob_l2c_pref, knob_llc_pref, knob_llc_repl);
+
+    // without a configuration file the compiled defaults are kept and nothing is reallocated
+    if (config_file)
+        load_config(config_file);
+
+    // shadow tag arrays only see the current region and start cold after a checkpoint
+    if (llc_shadow_policies) {
+        if (simpoint_file || load_checkpoint_file) {
+            cerr << "-llc_shadow cannot be combined with -simpoints or -load_checkpoint" << endl;
+            assert(0);
+        }
+        // some policies seed rand() in their initialization, so this has to happen before srand(seed_number)
+        add_shadow_llcs(llc_shadow_policies);
+    }
+
+    // one host thread per simulated core at most
+    if (knob_threads > NUM_CPUS)
+        knob_threads = NUM_CPUS;
+    if (knob_threads == 0)
+        knob_threads = 1;
+
     if (knob_low_bandwidth)
         DRAM_MTPS = DRAM_IO_FREQ/4;
     else
@@ -603,12 +1158,10 @@ int main(int argc, char** argv)
 			}
 				
 
-            if (full_name[last_dot - full_name + 1] == 'g') // gzip format
-                sprintf(ooo_cpu[count_traces].gunzip_command, "gunzip -c %s", argv[i]);
-            else if (full_name[last_dot - full_name + 1] == 'x') // xz
-                sprintf(ooo_cpu[count_traces].gunzip_command, "xz -dc %s", argv[i]);
-            else {
-                cout << "ChampSim does not support traces other than gz or xz compression!" << endl; 
+            // gzip, xz or chunked (.ctrace from champsim_trace_convert), decoded in process by the trace reader,
+            // or uncompressed (.champsimtrace), mapped
+            if ((full_name[last_dot - full_name + 1] != 'g') && (full_name[last_dot - full_name + 1] != 'x') && (full_name[last_dot - full_name + 1] != 'c')) {
+                cout << "ChampSim does not support traces other than gz, xz, ctrace or uncompressed champsimtrace!" << endl; 
                 assert(0);
             }
 
@@ -631,11 +1184,7 @@ int main(int argc, char** argv)
                 j++;
             }
 
-            ooo_cpu[count_traces].trace_file = popen(ooo_cpu[count_traces].gunzip_command, "r");
-            if (ooo_cpu[count_traces].trace_file == NULL) {
-                printf("\n*** Trace file not found: %s ***\n\n", argv[i]);
-                assert(0);
-            }
+            ooo_cpu[count_traces].trace_reader.open(ooo_cpu[count_traces].trace_string, knob_cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr), trace_cache_dir);
 
             count_traces++;
             if (count_traces > NUM_CPUS) {
@@ -665,6 +1214,15 @@ int main(int argc, char** argv)
         ooo_cpu[i].begin_sim_cycle = 0; 
         ooo_cpu[i].begin_sim_instr = warmup_instructions;
 
+        // sizes from -config
+        ooo_cpu[i].configure(core_config);
+        ooo_cpu[i].ITLB.configure(itlb_config);
+        ooo_cpu[i].DTLB.configure(dtlb_config);
+        ooo_cpu[i].STLB.configure(stlb_config);
+        ooo_cpu[i].L1I.configure(l1i_config);
+        ooo_cpu[i].L1D.configure(l1d_config);
+        ooo_cpu[i].L2C.configure(l2c_config);
+
         // ROB
         ooo_cpu[i].ROB.cpu = i;
 
@@ -700,6 +1258,7 @@ int main(int argc, char** argv)
 
         ooo_cpu[i].L1D.cpu = i;
         ooo_cpu[i].L1D.cache_type = IS_L1D;
+        ooo_cpu[i].L1D.WQ.set_match(QUEUE_MATCH_FULL_ADDR); // stores to the same block are separate writes
         ooo_cpu[i].L1D.MAX_READ = (2 > MAX_READ_PER_CYCLE) ? MAX_READ_PER_CYCLE : 2;
         ooo_cpu[i].L1D.fill_level = FILL_L1;
         ooo_cpu[i].L1D.lower_level = &ooo_cpu[i].L2C; 
@@ -745,80 +1304,105 @@ int main(int argc, char** argv)
         major_fault[i] = 0;
     }
 
+    uncore.LLC.configure(llc_config);
+    uncore.DRAM.configure();
+
     uncore.LLC.llc_initialize_replacement();
     uncore.LLC.llc_prefetcher_initialize();
 
     print_knobs();
 
-    // simulation entry point
+    // the L2Cs run ahead of the LLC and reach it through their mailboxes.
+    // a quantum of one cycle on one thread runs the cores in the same order as the main loop,
+    // so the L2Cs keep talking to the LLC directly and the results match the lockstep engine
+    if (knob_sync_quantum) {
+        for (int i=0; i<NUM_CPUS; i++) {
+            llc_mailbox[i].cpu = i;
+            llc_mailbox[i].shared_level = &uncore.LLC;
+            if ((knob_sync_quantum > 1) || (knob_threads > 1))
+                ooo_cpu[i].L2C.lower_level = &llc_mailbox[i];
+        }
+    }
+
     start_time = time(NULL);
-    uint8_t run_simulation = 1;
-    while (run_simulation) {
 
-        uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
-                 elapsed_minute = elapsed_second / 60,
-                 elapsed_hour = elapsed_minute / 60;
-        elapsed_minute -= elapsed_hour*60;
-        elapsed_second -= (elapsed_hour*3600 + elapsed_minute*60);
+    // a checkpoint replaces the whole warmup, simulation starts right after the instructions retired before it was saved
+    if (load_checkpoint_file) {
+        load_checkpoint(load_checkpoint_file);
+        cout << "Checkpoint loaded: " << load_checkpoint_file << endl;
 
         for (int i=0; i<NUM_CPUS; i++) {
-            // proceed one cycle
-            current_core_cycle[i]++;
-
-            //cout << "Trying to process instr_id: " << ooo_cpu[i].instr_unique_id << " fetch_stall: " << +ooo_cpu[i].fetch_stall;
-            //cout << " stall_cycle: " << stall_cycle[i] << " current: " << current_core_cycle[i] << endl;
-
-            // core might be stalled due to page fault or branch misprediction
-            if (stall_cycle[i] <= current_core_cycle[i]) {
+            ooo_cpu[i].skip_trace(ooo_cpu[i].num_retired);
+            ooo_cpu[i].instr_unique_id = ooo_cpu[i].num_retired;
+            ooo_cpu[i].next_print_instruction = (ooo_cpu[i].num_retired / STAT_PRINTING_PERIOD + 1) * STAT_PRINTING_PERIOD;
+            ooo_cpu[i].last_sim_instr = ooo_cpu[i].num_retired;
+            ooo_cpu[i].last_sim_cycle = current_core_cycle[i];
+            warmup_complete[i] = 1;
+        }
+        all_warmup_complete = NUM_CPUS + 1;
+        finish_warmup();
+    }
 
-                // fetch unit
-                if (ooo_cpu[i].ROB.occupancy < ooo_cpu[i].ROB.SIZE) {
-                    // handle branch
-                    if (ooo_cpu[i].fetch_stall == 0) 
-                        ooo_cpu[i].handle_branch();
-                }
+    // functional warmup of the tlbs, caches and branch predictors before the detailed warmup
+    // cores are interleaved one instruction at a time so that they share the LLC and the page table fairly
+    if (fast_forward_instructions) {
+        for (uint64_t n=0; n<fast_forward_instructions; n++) {
+            for (int i=0; i<NUM_CPUS; i++)
+                ooo_cpu[i].fast_forward_instruction();
+        }
 
-                // fetch
-                ooo_cpu[i].fetch_instruction();
+        for (int i=0; i<NUM_CPUS; i++) {
+            // page faults taken while fast-forwarding do not stall the detailed model
+            stall_cycle[i] = 0;
+            cout << "Fast-forward complete CPU " << i << " instructions: " << fast_forward_instructions << endl;
+        }
+        cout << endl;
+    }
 
+    if ((knob_threads > 1) || knob_sync_quantum) {
+        for (int i=0; i<NUM_CPUS; i++)
+            ooo_cpu[i].defer_output = 1;
+        core_threads.start(knob_threads, operate_core_phase);
+    }
 
-                // schedule (including decode latency)
-                uint32_t schedule_index = ooo_cpu[i].ROB.next_schedule;
-                if ((ooo_cpu[i].ROB.entry[schedule_index].scheduled == 0) && (ooo_cpu[i].ROB.entry[schedule_index].event_cycle <= current_core_cycle[i]))
-                    ooo_cpu[i].schedule_instruction();
+    if (simpoints.size()) {
+        simpoint_warmup = warmup_instructions;
+        begin_simpoint();
+    }
 
-                // execute
-                ooo_cpu[i].execute_instruction();
+    // simulation entry point
+    uint8_t run_simulation = 1;
+    while (run_simulation) {
 
-                // memory operation
-                ooo_cpu[i].schedule_memory_instruction();
-                ooo_cpu[i].execute_memory_instruction();
+        if (knob_sync_quantum) {
+            run_simulation = simulate_quantum();
+            continue;
+        }
 
-                // complete 
-                ooo_cpu[i].update_rob();
+        uint8_t parallel_cycle = (knob_threads > 1) && parallel_cycle_allowed();
+        if (parallel_cycle)
+            operate_cores_parallel();
 
-                // retire
-                if ((ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].executed == COMPLETED) && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle <= current_core_cycle[i]))
-                    ooo_cpu[i].retire_rob();
+        for (int i=0; i<NUM_CPUS; i++) {
+            if (parallel_cycle == 0) {
+                // proceed one cycle
+                current_core_cycle[i]++;
+
+                //cout << "Trying to process instr_id: " << ooo_cpu[i].instr_unique_id << " fetch_stall: " << +ooo_cpu[i].fetch_stall;
+                //cout << " stall_cycle: " << stall_cycle[i] << " current: " << current_core_cycle[i] << endl;
+
+                // core might be stalled due to page fault or branch misprediction
+                if (stall_cycle[i] <= current_core_cycle[i]) {
+                    operate_core_front(i);
+                    flush_core_output(i);
+                    operate_core_shared(i);
+                    operate_core_back(i);
+                }
             }
 
             // heartbeat information
-            if (show_heartbeat && (ooo_cpu[i].num_retired >= ooo_cpu[i].next_print_instruction)) {
-                float cumulative_ipc;
-                if (warmup_complete[i])
-                    cumulative_ipc = (1.0*(ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr)) / (current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle);
-                else
-                    cumulative_ipc = (1.0*ooo_cpu[i].num_retired) / current_core_cycle[i];
-                float heartbeat_ipc = (1.0*ooo_cpu[i].num_retired - ooo_cpu[i].last_sim_instr) / (current_core_cycle[i] - ooo_cpu[i].last_sim_cycle);
-
-                cout << "Heartbeat CPU " << setw(2) << i << " instructions: " << setw(10) << ooo_cpu[i].num_retired << " cycles: " << setw(10) << current_core_cycle[i];
-                cout << " heartbeat IPC: " << FIXED_FLOAT(heartbeat_ipc) << " cumulative IPC: " << FIXED_FLOAT(cumulative_ipc); 
-                cout << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
-                ooo_cpu[i].next_print_instruction += STAT_PRINTING_PERIOD;
-
-                ooo_cpu[i].last_sim_instr = ooo_cpu[i].num_retired;
-                ooo_cpu[i].last_sim_cycle = current_core_cycle[i];
-            }
+            if (show_heartbeat && (ooo_cpu[i].num_retired >= ooo_cpu[i].next_print_instruction))
+                print_heartbeat(i, cout);
 
             // check for deadlock
             if (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].ip && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle + DEADLOCK_CYCLE) <= current_core_cycle[i])
@@ -846,31 +1430,24 @@ int main(int argc, char** argv)
             
             // simulation complete
             if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && (ooo_cpu[i].num_retired >= (ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions))) {
-                simulation_complete[i] = 1;
-                ooo_cpu[i].finish_sim_instr = ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr;
-                ooo_cpu[i].finish_sim_cycle = current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle;
-
-                cout << "Finished CPU " << i << " instructions: " << ooo_cpu[i].finish_sim_instr << " cycles: " << ooo_cpu[i].finish_sim_cycle;
-                cout << " cumulative IPC: " << ((float) ooo_cpu[i].finish_sim_instr / ooo_cpu[i].finish_sim_cycle);
-                cout << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
-
-                record_roi_stats(i, &ooo_cpu[i].L1D);
-                record_roi_stats(i, &ooo_cpu[i].L1I);
-                record_roi_stats(i, &ooo_cpu[i].L2C);
-                record_roi_stats(i, &uncore.LLC);
-
+                finish_simulation(i, cout);
                 all_simulation_complete++;
             }
 
             if (all_simulation_complete == NUM_CPUS)
-                run_simulation = 0;
+                run_simulation = simpoints.size() ? simpoint_step() : 0;
         }
 
         // TODO: should it be backward?
         uncore.LLC.operate();
         uncore.DRAM.operate();
+
+        if (knob_event_skip && run_simulation)
+            skip_idle_cycles();
     }
 
+    core_threads.stop();
+
     uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
              elapsed_minute = elapsed_second / 60,
              elapsed_hour = elapsed_minute / 60;
@@ -909,6 +1486,7 @@ int main(int argc, char** argv)
         print_roi_stats(i, &ooo_cpu[i].L2C);
 #endif
         print_roi_stats(i, &uncore.LLC);
+        print_shadow_llc_stats(i);
         cout << "Core_" << i << "_major_page_fault " << major_fault[i] << endl
             << "Core_" << i << "_minor_page_fault " << minor_fault[i] << endl
             << endl;
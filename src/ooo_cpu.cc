@@ -5,6 +5,9 @@
 O3_CPU ooo_cpu[NUM_CPUS]; 
 uint64_t current_core_cycle[NUM_CPUS], stall_cycle[NUM_CPUS];
 uint32_t SCHEDULING_LATENCY = 0, EXEC_LATENCY = 0;
+uint32_t FETCH_WIDTH = 6, DECODE_WIDTH = 6, EXEC_WIDTH = 4, LQ_WIDTH = 2, SQ_WIDTH = 2, RETIRE_WIDTH = 4,
+         SCHEDULER_SIZE = 128, BRANCH_MISPREDICT_PENALTY = 20;
+CORE_CONFIG core_config = {ROB_SIZE, LQ_SIZE, SQ_SIZE};
 
 void print_core_config()
 {
@@ -16,9 +19,9 @@ void print_core_config()
         << "retire_width " << RETIRE_WIDTH << endl
         << "scheduler_size " << SCHEDULER_SIZE << endl
         << "branch_mispredict_penalty " << BRANCH_MISPREDICT_PENALTY << endl
-        << "rob_size " << ROB_SIZE << endl
-        << "lq_size " << LQ_SIZE << endl
-        << "sq_size " << SQ_SIZE << endl
+        << "rob_size " << core_config.rob_size << endl
+        << "lq_size " << core_config.lq_size << endl
+        << "sq_size " << core_config.sq_size << endl
         << "num_instr_destinations_sparc " << NUM_INSTR_DESTINATIONS_SPARC << endl
         << "num_instr_destinations " << NUM_INSTR_DESTINATIONS << endl
         << "num_instr_sources " << NUM_INSTR_SOURCES << endl
@@ -30,294 +33,189 @@ void O3_CPU::initialize_core()
 
 }
 
-void O3_CPU::handle_branch()
+// called before the simulation starts
+void O3_CPU::configure(const CORE_CONFIG &config)
 {
-    // actual processors do not work like this but for easier implementation,
-    // we read instruction traces and virtually add them in the ROB
-    // note that these traces are not yet translated and fetched 
-
-    uint8_t continue_reading = 1;
-    uint32_t num_reads = 0;
-    instrs_to_read_this_cycle = FETCH_WIDTH;
-
-    // first, read PIN trace
-    while (continue_reading) {
-
-        size_t instr_size = knob_cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr);
-
-        if (knob_cloudsuite) {
-            if (!fread(&current_cloudsuite_instr, instr_size, 1, trace_file)) {
-                // reached end of file for this trace
-                cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
-
-                // close the trace file and re-open it
-                pclose(trace_file);
-                trace_file = popen(gunzip_command, "r");
-                if (trace_file == NULL) {
-                    cerr << endl << "*** CANNOT REOPEN TRACE FILE: " << trace_string << " ***" << endl;
-                    assert(0);
-                }
-            } else { // successfully read the trace
-
-                // copy the instruction into the performance model's instruction format
-                ooo_model_instr arch_instr;
-                int num_reg_ops = 0, num_mem_ops = 0;
-
-                arch_instr.instr_id = instr_unique_id;
-                arch_instr.ip = current_cloudsuite_instr.ip;
-                arch_instr.is_branch = current_cloudsuite_instr.is_branch;
-                arch_instr.branch_taken = current_cloudsuite_instr.branch_taken;
-
-                arch_instr.asid[0] = current_cloudsuite_instr.asid[0];
-                arch_instr.asid[1] = current_cloudsuite_instr.asid[1];
-
-                for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
-                    arch_instr.destination_registers[i] = current_cloudsuite_instr.destination_registers[i];
-                    arch_instr.destination_memory[i] = current_cloudsuite_instr.destination_memory[i];
-                    arch_instr.destination_virtual_address[i] = current_cloudsuite_instr.destination_memory[i];
-
-                    if (arch_instr.destination_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.destination_memory[i]) {
-                        num_mem_ops++;
-
-                        // update STA, this structure is required to execute store instructios properly without deadlock
-                        if (num_mem_ops > 0) {
-#ifdef SANITY_CHECK
-                            if (STA[STA_tail] < UINT64_MAX) {
-                                if (STA_head != STA_tail)
-                                    assert(0);
-                            }
-#endif
-                            STA[STA_tail] = instr_unique_id;
-                            STA_tail++;
-
-                            if (STA_tail == STA_SIZE)
-                                STA_tail = 0;
-                        }
-                    }
-                }
-
-                for (int i=0; i<NUM_INSTR_SOURCES; i++) {
-                    arch_instr.source_registers[i] = current_cloudsuite_instr.source_registers[i];
-                    arch_instr.source_memory[i] = current_cloudsuite_instr.source_memory[i];
-                    arch_instr.source_virtual_address[i] = current_cloudsuite_instr.source_memory[i];
-
-                    if (arch_instr.source_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.source_memory[i])
-                        num_mem_ops++;
-                }
-
-                arch_instr.num_reg_ops = num_reg_ops;
-                arch_instr.num_mem_ops = num_mem_ops;
-                if (num_mem_ops > 0) 
-                    arch_instr.is_memory = 1;
-
-                // virtually add this instruction to the ROB
-                if (ROB.occupancy < ROB.SIZE) {
-                    uint32_t rob_index = add_to_rob(&arch_instr);
-                    num_reads++;
-
-                    // branch prediction
-                    if (arch_instr.is_branch) {
-
-                        DP( if (warmup_complete[cpu]) {
-                        cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec << " taken: " << +arch_instr.branch_taken << endl; });
-
-                        num_branch++;
+    if ((config.rob_size == ROB.SIZE) && (config.lq_size == LQ.SIZE) && (config.sq_size == SQ.SIZE))
+        return;
 
-                        /*
-                        uint8_t branch_prediction;
-                        // for faster simulation, force perfect prediction during the warmup
-                        // note that branch predictor is still learning with real branch results
-                        if (all_warmup_complete == 0)
-                            branch_prediction = arch_instr.branch_taken; 
-                        else
-                            branch_prediction = predict_branch(arch_instr.ip);
-                        */
-                        uint8_t branch_prediction = predict_branch(arch_instr.ip);
-                        
-                        if (arch_instr.branch_taken != branch_prediction) {
-   			    //if(false) { // this simulates perfect branch prediction			  
-                            branch_mispredictions++;
+    ROB.resize(config.rob_size);
+    LQ.resize(config.lq_size);
+    SQ.resize(config.sq_size);
+    reset_ready_queues();
 
-			    total_rob_occupancy_at_branch_mispredict +=	ROB.occupancy;
+    // completed translations and fetches wait here until the core picks them up
+    ITLB.PROCESSED.resize(ROB.SIZE);
+    DTLB.PROCESSED.resize(ROB.SIZE);
+    L1I.PROCESSED.resize(ROB.SIZE);
+    L1D.PROCESSED.resize(ROB.SIZE);
+}
 
-                            DP( if (warmup_complete[cpu]) {
-                            cout << "[BRANCH] MISPREDICTED instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
-                            cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
+// converts a trace record, counting its operands once here instead of in the front end
+template <class T>
+static void decode_record(const T *record, decoded_instr *instr)
+{
+    const uint32_t num_destinations = sizeof(record->destination_registers);
+
+    instr->ip = record->ip;
+    instr->is_branch = record->is_branch;
+    instr->branch_taken = record->branch_taken;
+    instr->num_reg_ops = 0;
+    instr->num_stores = 0;
+
+    for (uint32_t i=0; i<NUM_INSTR_DESTINATIONS_SPARC; i++) {
+        instr->destination_registers[i] = (i < num_destinations) ? record->destination_registers[i] : 0;
+        instr->destination_memory[i] = (i < num_destinations) ? record->destination_memory[i] : 0;
+
+        if (instr->destination_registers[i])
+            instr->num_reg_ops++;
+        if (instr->destination_memory[i])
+            instr->num_stores++;
+    }
+    instr->num_mem_ops = instr->num_stores;
 
-                            // halt any further fetch this cycle
-                            instrs_to_read_this_cycle = 0;
+    for (uint32_t i=0; i<NUM_INSTR_SOURCES; i++) {
+        instr->source_registers[i] = record->source_registers[i];
+        instr->source_memory[i] = record->source_memory[i];
 
-                            // and stall any additional fetches until the branch is executed
-                            fetch_stall = 1; 
+        if (instr->source_registers[i])
+            instr->num_reg_ops++;
+        if (instr->source_memory[i])
+            instr->num_mem_ops++;
+    }
+}
 
-                            ROB.entry[rob_index].branch_mispredicted = 1;
-                        }
-                        else {
-                            if (branch_prediction == 1) {
-                                // if we are accurately predicting a branch to be taken, then we can't possibly fetch down that path this cycle,
-                                // so we have to wait until the next cycle to fetch those
-                                instrs_to_read_this_cycle = 0;
-                            }
-
-                            DP( if (warmup_complete[cpu]) {
-                            cout << "[BRANCH] PREDICTED    instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
-                            cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
-                        }
+// decodes up to DECODE_BUFFER_SIZE records of the trace, returns 0 at its end
+uint32_t O3_CPU::fill_decode_buffer()
+{
+    decode_head = 0;
+    decode_tail = 0;
 
-                        last_branch_result(arch_instr.ip, arch_instr.branch_taken);
-                    }
+    while (decode_tail < DECODE_BUFFER_SIZE) {
+        const uint8_t *record = trace_reader.next();
+        if (record == NULL)
+            break;
 
-                    //if ((num_reads == FETCH_WIDTH) || (ROB.occupancy == ROB.SIZE))
-                    if ((num_reads >= instrs_to_read_this_cycle) || (ROB.occupancy == ROB.SIZE))
-                        continue_reading = 0;
-                }
-                instr_unique_id++;
-            }
+        decoded_instr *instr = &decode_buffer[decode_tail++];
+        if (knob_cloudsuite) {
+            const cloudsuite_instr *current_cloudsuite_instr = (const cloudsuite_instr *)record;
+            decode_record(current_cloudsuite_instr, instr);
+            instr->asid[0] = current_cloudsuite_instr->asid[0];
+            instr->asid[1] = current_cloudsuite_instr->asid[1];
         }
-	else
-	  {
-            if (!fread(&current_instr, instr_size, 1, trace_file)) {
-                // reached end of file for this trace
-                cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
-
-                // close the trace file and re-open it
-                pclose(trace_file);
-                trace_file = popen(gunzip_command, "r");
-                if (trace_file == NULL) {
-                    cerr << endl << "*** CANNOT REOPEN TRACE FILE: " << trace_string << " ***" << endl;
-                    assert(0);
-                }
-            } else { // successfully read the trace
+        else {
+            decode_record((const input_instr *)record, instr);
+            instr->asid[0] = cpu;
+            instr->asid[1] = cpu;
+        }
+    }
 
-                // copy the instruction into the performance model's instruction format
-                ooo_model_instr arch_instr;
-                int num_reg_ops = 0, num_mem_ops = 0;
+    return decode_tail;
+}
 
-                arch_instr.instr_id = instr_unique_id;
-                arch_instr.ip = current_instr.ip;
-                arch_instr.is_branch = current_instr.is_branch;
-                arch_instr.branch_taken = current_instr.branch_taken;
+// the end of the trace is only acted upon once the buffer runs dry, at the same instruction as reading one record at a time
+const decoded_instr *O3_CPU::next_instr()
+{
+    while (decode_head == decode_tail) {
+        if (fill_decode_buffer() == 0)
+            // reached end of file for this trace
+            reopen_trace();
+    }
 
-                arch_instr.asid[0] = cpu;
-                arch_instr.asid[1] = cpu;
+    return &decode_buffer[decode_head++];
+}
 
-                for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
-                    arch_instr.destination_registers[i] = current_instr.destination_registers[i];
-                    arch_instr.destination_memory[i] = current_instr.destination_memory[i];
-                    arch_instr.destination_virtual_address[i] = current_instr.destination_memory[i];
+void O3_CPU::handle_branch()
+{
+    // actual processors do not work like this but for easier implementation,
+    // we read instruction traces and virtually add them in the ROB
+    // note that these traces are not yet translated and fetched 
+
+    uint32_t num_reads = 0;
+    instrs_to_read_this_cycle = FETCH_WIDTH;
 
-                    if (arch_instr.destination_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.destination_memory[i]) {
-                        num_mem_ops++;
+    // first, read PIN trace
+    while ((num_reads < instrs_to_read_this_cycle) && (ROB.occupancy < ROB.SIZE)) {
+        const decoded_instr *instr = next_instr();
 
-                        // update STA, this structure is required to execute store instructios properly without deadlock
-                        if (num_mem_ops > 0) {
+        // update STA, this structure is required to execute store instructios properly without deadlock
+        for (uint32_t i=0; i<instr->num_stores; i++) {
 #ifdef SANITY_CHECK
-                            if (STA[STA_tail] < UINT64_MAX) {
-                                if (STA_head != STA_tail)
-                                    assert(0);
-                            }
+            if (STA[STA_tail] < UINT64_MAX) {
+                if (STA_head != STA_tail)
+                    assert(0);
+            }
 #endif
-                            STA[STA_tail] = instr_unique_id;
-                            STA_tail++;
-
-                            if (STA_tail == STA_SIZE)
-                                STA_tail = 0;
-                        }
-                    }
-                }
-
-                for (int i=0; i<NUM_INSTR_SOURCES; i++) {
-                    arch_instr.source_registers[i] = current_instr.source_registers[i];
-                    arch_instr.source_memory[i] = current_instr.source_memory[i];
-                    arch_instr.source_virtual_address[i] = current_instr.source_memory[i];
-
-                    if (arch_instr.source_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.source_memory[i])
-                        num_mem_ops++;
-                }
-
-                arch_instr.num_reg_ops = num_reg_ops;
-                arch_instr.num_mem_ops = num_mem_ops;
-                if (num_mem_ops > 0) 
-                    arch_instr.is_memory = 1;
+            STA[STA_tail] = instr_unique_id;
+            STA_tail++;
 
-                // virtually add this instruction to the ROB
-                if (ROB.occupancy < ROB.SIZE) {
-                    uint32_t rob_index = add_to_rob(&arch_instr);
-                    num_reads++;
+            if (STA_tail == STA_SIZE)
+                STA_tail = 0;
+        }
 
-                    // branch prediction
-                    if (arch_instr.is_branch) {
+        // virtually add this instruction to the ROB
+        uint32_t rob_index = add_to_rob(instr);
+        num_reads++;
 
-                        DP( if (warmup_complete[cpu]) {
-                        cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec << " taken: " << +arch_instr.branch_taken << endl; });
+        // branch prediction
+        if (instr->is_branch) {
 
-                        num_branch++;
+            DP( if (warmup_complete[cpu]) {
+            cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << instr->ip << dec << " taken: " << +instr->branch_taken << endl; });
 
-                        /*
-                        uint8_t branch_prediction;
-                        // for faster simulation, force perfect prediction during the warmup
-                        // note that branch predictor is still learning with real branch results
-                        if (all_warmup_complete == 0)
-                            branch_prediction = arch_instr.branch_taken; 
-                        else
-                            branch_prediction = predict_branch(arch_instr.ip);
-                        */
-                        uint8_t branch_prediction = predict_branch(arch_instr.ip);
-                        
-                        if (arch_instr.branch_taken != branch_prediction) {
-			    //if(false) { // this simulates perfect branch prediction
-			    branch_mispredictions++;
+            num_branch++;
 
-			    total_rob_occupancy_at_branch_mispredict += ROB.occupancy;
+            /*
+            uint8_t branch_prediction;
+            // for faster simulation, force perfect prediction during the warmup
+            // note that branch predictor is still learning with real branch results
+            if (all_warmup_complete == 0)
+                branch_prediction = instr->branch_taken; 
+            else
+                branch_prediction = predict_branch(instr->ip);
+            */
+            uint8_t branch_prediction = predict_branch(instr->ip);
 
-                            DP( if (warmup_complete[cpu]) {
-                            cout << "[BRANCH] MISPREDICTED instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
-                            cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
+            if (instr->branch_taken != branch_prediction) {
+                //if(false) { // this simulates perfect branch prediction
+                branch_mispredictions++;
 
-                            // halt any further fetch this cycle
-                            instrs_to_read_this_cycle = 0;
+                total_rob_occupancy_at_branch_mispredict += ROB.occupancy;
 
-                            // and stall any additional fetches until the branch is executed
-                            fetch_stall = 1; 
+                DP( if (warmup_complete[cpu]) {
+                cout << "[BRANCH] MISPREDICTED instr_id: " << instr_unique_id << " ip: " << hex << instr->ip << dec;
+                cout << " taken: " << +instr->branch_taken << " predicted: " << +branch_prediction << endl; });
 
-                            ROB.entry[rob_index].branch_mispredicted = 1;
-                        }
-                        else {
-                            if (branch_prediction == 1) {
-                                // if we are accurately predicting a branch to be taken, then we can't possibly fetch down that path this cycle,
-                                // so we have to wait until the next cycle to fetch those
-                                instrs_to_read_this_cycle = 0;
-                            }
-
-                            DP( if (warmup_complete[cpu]) {
-                            cout << "[BRANCH] PREDICTED    instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
-                            cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
-                        }
+                // halt any further fetch this cycle
+                instrs_to_read_this_cycle = 0;
 
-                        last_branch_result(arch_instr.ip, arch_instr.branch_taken);
-                    }
+                // and stall any additional fetches until the branch is executed
+                fetch_stall = 1; 
 
-                    //if ((num_reads == FETCH_WIDTH) || (ROB.occupancy == ROB.SIZE))
-                    if ((num_reads >= instrs_to_read_this_cycle) || (ROB.occupancy == ROB.SIZE))
-                        continue_reading = 0;
+                ROB.entry[rob_index].branch_mispredicted = 1;
+            }
+            else {
+                if (branch_prediction == 1) {
+                    // if we are accurately predicting a branch to be taken, then we can't possibly fetch down that path this cycle,
+                    // so we have to wait until the next cycle to fetch those
+                    instrs_to_read_this_cycle = 0;
                 }
-                instr_unique_id++;
+
+                DP( if (warmup_complete[cpu]) {
+                cout << "[BRANCH] PREDICTED    instr_id: " << instr_unique_id << " ip: " << hex << instr->ip << dec;
+                cout << " taken: " << +instr->branch_taken << " predicted: " << +branch_prediction << endl; });
             }
+
+            last_branch_result(instr->ip, instr->branch_taken);
         }
+
+        instr_unique_id++;
     }
 
     //instrs_to_fetch_this_cycle = num_reads;
 }
 
-uint32_t O3_CPU::add_to_rob(ooo_model_instr *arch_instr)
+uint32_t O3_CPU::add_to_rob(const decoded_instr *instr)
 {
     uint32_t index = ROB.tail;
 
@@ -328,8 +226,57 @@ uint32_t O3_CPU::add_to_rob(ooo_model_instr *arch_instr)
         assert(0);
     }
 
-    ROB.entry[index] = *arch_instr;
-    ROB.entry[index].event_cycle = current_core_cycle[cpu];
+    // retire_rob() left the entry empty, only the fields coming from the trace are filled in
+    ooo_model_instr &entry = ROB.entry[index];
+    entry.instr_id = instr_unique_id;
+    entry.ip = instr->ip;
+    entry.is_branch = instr->is_branch;
+    entry.branch_taken = instr->branch_taken;
+    entry.asid[0] = instr->asid[0];
+    entry.asid[1] = instr->asid[1];
+
+    for (uint32_t i=0; i<NUM_INSTR_DESTINATIONS_SPARC; i++) {
+        entry.destination_registers[i] = instr->destination_registers[i];
+        entry.destination_memory[i] = instr->destination_memory[i];
+        entry.destination_virtual_address[i] = instr->destination_memory[i];
+    }
+
+    for (uint32_t i=0; i<NUM_INSTR_SOURCES; i++) {
+        entry.source_registers[i] = instr->source_registers[i];
+        entry.source_memory[i] = instr->source_memory[i];
+        entry.source_virtual_address[i] = instr->source_memory[i];
+    }
+
+    // the sources read the last writers before this instruction becomes the last writer of its destinations
+    for (uint32_t i=0; i<NUM_INSTR_SOURCES; i++) {
+        if (entry.source_registers[i])
+            entry.source_writer[i] = last_writer[entry.source_registers[i]];
+    }
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        ROB_WRITER &writer = last_writer[entry.destination_registers[i]];
+        if (entry.destination_registers[i] && ((writer.rob_index != index) || (writer.instr_id != entry.instr_id))) {
+            entry.prior_writer[i] = writer;
+            writer.rob_index = index;
+            writer.instr_id = entry.instr_id;
+        }
+    }
+
+    // and the loads the youngest store to their address
+    for (uint32_t i=0; i<NUM_INSTR_SOURCES; i++) {
+        if (entry.source_memory[i])
+            entry.source_store[i] = store_index.find(entry.source_memory[i]);
+    }
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        if (entry.destination_memory[i])
+            store_index.insert(entry.destination_memory[i], index, entry.instr_id);
+    }
+
+    entry.num_reg_ops = instr->num_reg_ops;
+    entry.num_mem_ops = instr->num_mem_ops;
+    if (instr->num_mem_ops > 0)
+        entry.is_memory = 1;
+
+    set_event_cycle(index, current_core_cycle[cpu]);
 
     ROB.occupancy++;
     ROB.tail++;
@@ -355,34 +302,17 @@ uint32_t O3_CPU::add_to_rob(ooo_model_instr *arch_instr)
 
 uint32_t O3_CPU::check_rob(uint64_t instr_id)
 {
-    if ((ROB.head == ROB.tail) && ROB.occupancy == 0)
-        return ROB.SIZE;
-
-    if (ROB.head < ROB.tail) {
-        for (uint32_t i=ROB.head; i<ROB.tail; i++) {
-            if (ROB.entry[i].instr_id == instr_id) {
-                DP ( if (warmup_complete[ROB.cpu]) {
-                cout << "[ROB] " << __func__ << " same instr_id: " << ROB.entry[i].instr_id;
-                cout << " rob_index: " << i << endl; });
-                return i;
-            }
-        }
-    }
-    else {
-        for (uint32_t i=ROB.head; i<ROB.SIZE; i++) {
-            if (ROB.entry[i].instr_id == instr_id) {
+    // instructions enter the ROB with consecutive instr_ids and leave it in order,
+    // so an instruction sits as many entries after the head as its id is past the head's
+    if (ROB.occupancy) {
+        uint64_t head_id = ROB.entry[ROB.head].instr_id;
+        if ((instr_id >= head_id) && ((instr_id - head_id) < ROB.occupancy)) {
+            uint32_t index = (ROB.head + (instr_id - head_id)) % ROB.SIZE;
+            if (ROB.entry[index].instr_id == instr_id) {
                 DP ( if (warmup_complete[cpu]) {
-                cout << "[ROB] " << __func__ << " same instr_id: " << ROB.entry[i].instr_id;
-                cout << " rob_index: " << i << endl; });
-                return i;
-            }
-        }
-        for (uint32_t i=0; i<ROB.tail; i++) {
-            if (ROB.entry[i].instr_id == instr_id) {
-                DP ( if (warmup_complete[cpu]) {
-                cout << "[ROB] " << __func__ << " same instr_id: " << ROB.entry[i].instr_id;
-                cout << " rob_index: " << i << endl; });
-                return i;
+                cout << "[ROB] " << __func__ << " same instr_id: " << ROB.entry[index].instr_id;
+                cout << " rob_index: " << index << endl; });
+                return index;
             }
         }
     }
@@ -394,6 +324,120 @@ uint32_t O3_CPU::check_rob(uint64_t instr_id)
     return ROB.SIZE;
 }
 
+void O3_CPU::reopen_trace()
+{
+    ostream &out = defer_output ? (ostream &)deferred_output : cout;
+
+    out << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
+
+    // start the trace again from its beginning, a mapped trace only resets its position
+    trace_reader.rewind();
+}
+
+void O3_CPU::skip_trace(uint64_t num_instrs)
+{
+    // instructions already decoded come first
+    uint64_t buffered = decode_tail - decode_head;
+    if (num_instrs <= buffered) {
+        decode_head += num_instrs;
+        return;
+    }
+    num_instrs -= buffered;
+    decode_head = 0;
+    decode_tail = 0;
+
+    // a chunked or mapped trace jumps to the block of the target instruction, the passes over the end are repeated like reading would
+    if (trace_reader.seekable()) {
+        uint64_t target = trace_reader.current_record() + num_instrs;
+        while (trace_reader.num_records && (target > trace_reader.num_records)) {
+            target -= trace_reader.num_records;
+            reopen_trace();
+        }
+        trace_reader.seek(target);
+        return;
+    }
+
+    for (uint64_t i=0; i<num_instrs; i++) {
+        while (trace_reader.next() == NULL)
+            reopen_trace();
+    }
+}
+
+uint64_t O3_CPU::functional_translate(CACHE *tlb, uint64_t va, uint64_t vpage, uint8_t type)
+{
+    PACKET tlb_packet;
+
+    tlb_packet.cpu = cpu;
+    tlb_packet.address = vpage;
+    tlb_packet.full_addr = va;
+    tlb_packet.instr_id = instr_unique_id;
+    tlb_packet.type = type;
+
+    tlb->functional_access(&tlb_packet);
+
+    return (tlb_packet.data << LOG2_PAGE_SIZE) | (va & ((1 << LOG2_PAGE_SIZE) - 1));
+}
+
+void O3_CPU::functional_data_access(uint64_t va, uint64_t ip, uint8_t asid, uint8_t type)
+{
+    uint64_t vpage = va >> LOG2_PAGE_SIZE;
+    if (knob_cloudsuite)
+        vpage = (vpage << 9) | asid;
+
+    PACKET data_packet;
+
+    data_packet.cpu = cpu;
+    data_packet.full_addr = functional_translate(&DTLB, va, vpage, type);
+    data_packet.address = data_packet.full_addr >> LOG2_BLOCK_SIZE;
+    data_packet.instr_id = instr_unique_id;
+    data_packet.ip = ip;
+    data_packet.type = type;
+
+    L1D.functional_access(&data_packet);
+}
+
+void O3_CPU::fast_forward_instruction()
+{
+    // read one instruction and only warm up the tlbs, caches and branch predictor with it
+    const decoded_instr *instr = next_instr();
+    uint64_t ip = instr->ip;
+
+    // instruction fetch
+    uint64_t vpage = ip >> LOG2_PAGE_SIZE;
+    if (knob_cloudsuite)
+        vpage = (vpage << 9) | (256 + instr->asid[0]);
+
+    PACKET fetch_packet;
+
+    fetch_packet.instruction = 1;
+    fetch_packet.cpu = cpu;
+    fetch_packet.full_addr = functional_translate(&ITLB, ip, vpage, LOAD);
+    fetch_packet.address = fetch_packet.full_addr >> LOG2_BLOCK_SIZE;
+    fetch_packet.instr_id = instr_unique_id;
+    fetch_packet.ip = ip;
+    fetch_packet.type = LOAD;
+
+    L1I.functional_access(&fetch_packet);
+
+    if (instr->is_branch) {
+        predict_branch(ip);
+        last_branch_result(ip, instr->branch_taken);
+    }
+
+    // data accesses, loads before stores
+    for (uint32_t i=0; i<NUM_INSTR_SOURCES; i++) {
+        if (instr->source_memory[i])
+            functional_data_access(instr->source_memory[i], ip, instr->asid[1], LOAD);
+    }
+
+    for (uint32_t i=0; i<NUM_INSTR_DESTINATIONS_SPARC; i++) {
+        if (instr->destination_memory[i])
+            functional_data_access(instr->destination_memory[i], ip, instr->asid[1], RFO);
+    }
+
+    instr_unique_id++;
+}
+
 void O3_CPU::fetch_instruction()
 {
     // TODO: can we model wrong path execusion?
@@ -437,7 +481,6 @@ void O3_CPU::fetch_instruction()
         trace_packet.full_addr = ROB.entry[read_index].ip;
         trace_packet.instr_id = ROB.entry[read_index].instr_id;
         trace_packet.rob_index = read_index;
-        trace_packet.producer = 0; // TODO: check if this guy gets used or not
         trace_packet.ip = ROB.entry[read_index].ip;
         trace_packet.type = LOAD; 
         trace_packet.asid[0] = ROB.entry[read_index].asid[0];
@@ -495,7 +538,6 @@ void O3_CPU::fetch_instruction()
         fetch_packet.full_addr = ROB.entry[fetch_index].instruction_pa;
         fetch_packet.instr_id = ROB.entry[fetch_index].instr_id;
         fetch_packet.rob_index = fetch_index;
-        fetch_packet.producer = 0;
         fetch_packet.ip = ROB.entry[fetch_index].ip;
         fetch_packet.type = LOAD; 
         fetch_packet.asid[0] = ROB.entry[fetch_index].asid[0];
@@ -537,38 +579,29 @@ void O3_CPU::schedule_instruction()
         return;
 
     // execution is out-of-order but we have an in-order scheduling algorithm to detect all RAW dependencies
-    uint32_t limit = ROB.next_fetch[1];
-    num_searched = 0;
-    if (ROB.head < limit) {
-        for (uint32_t i=ROB.head; i<limit; i++) { 
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                return;
-
-            if (ROB.entry[i].scheduled == 0)
-                do_scheduling(i);
-
-            num_searched++;
-        }
-    }
-    else {
-        for (uint32_t i=ROB.head; i<ROB.SIZE; i++) {
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                return;
-
-            if (ROB.entry[i].scheduled == 0)
-                do_scheduling(i);
+    // the scan stops at the first entry that is not ready, the already scheduled part of the window is
+    // only looked up for such an entry and the walk starts at the first unscheduled one
+    uint32_t limit = ROB.next_fetch[1],
+             window = (ROB.head < limit) ? (limit - ROB.head) : (ROB.SIZE - ROB.head + limit),
+             scheduled = scheduled_window();
+    if (scheduled > window)
+        scheduled = window;
+    if (scheduled > SCHEDULER_SIZE)
+        scheduled = SCHEDULER_SIZE;
+
+    if (find_later_in_window(rob_event, 0, scheduled, current_core_cycle[cpu]) < scheduled)
+        return;
 
-            num_searched++;
-        }
-        for (uint32_t i=0; i<limit; i++) { 
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                return;
+    num_searched = scheduled;
+    for (uint32_t n=scheduled; n<window; n++) {
+        uint32_t i = (ROB.head + n) % ROB.SIZE;
+        if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
+            return;
 
-            if (ROB.entry[i].scheduled == 0)
-                do_scheduling(i);
+        if (ROB.entry[i].scheduled == 0)
+            do_scheduling(i);
 
-            num_searched++;
-        }
+        num_searched++;
     }
 }
 
@@ -579,21 +612,24 @@ void O3_CPU::do_scheduling(uint32_t rob_index)
     reg_dependency(rob_index);
     ROB.next_schedule = (rob_index == (ROB.SIZE - 1)) ? 0 : (rob_index + 1);
 
-    if (ROB.entry[rob_index].is_memory)
+    if (ROB.entry[rob_index].is_memory) {
         ROB.entry[rob_index].scheduled = INFLIGHT;
+        if (ROB.entry[rob_index].reg_ready)
+            memory_ready.insert(rob_index);
+    }
     else {
         ROB.entry[rob_index].scheduled = COMPLETED;
 
         // ADD LATENCY
         if (ROB.entry[rob_index].event_cycle < current_core_cycle[cpu])
-            ROB.entry[rob_index].event_cycle = current_core_cycle[cpu] + SCHEDULING_LATENCY;
+            set_event_cycle(rob_index, current_core_cycle[cpu] + SCHEDULING_LATENCY);
         else
-            ROB.entry[rob_index].event_cycle += SCHEDULING_LATENCY;
+            set_event_cycle(rob_index, ROB.entry[rob_index].event_cycle + SCHEDULING_LATENCY);
 
         if (ROB.entry[rob_index].reg_ready) {
 
 #ifdef SANITY_CHECK
-            if (RTE1[RTE1_tail] < ROB_SIZE)
+            if (RTE1[RTE1_tail] < ROB.SIZE)
                 assert(0);
 #endif
             // remember this rob_index in the Ready-To-Execute array 1
@@ -604,7 +640,7 @@ void O3_CPU::do_scheduling(uint32_t rob_index)
             cout << " head: " << RTE1_head << " tail: " << RTE1_tail << endl; }); 
 
             RTE1_tail++;
-            if (RTE1_tail == ROB_SIZE)
+            if (RTE1_tail == ROB.SIZE)
                 RTE1_tail = 0;
         }
     }
@@ -628,33 +664,66 @@ void O3_CPU::reg_dependency(uint32_t rob_index)
     } }); 
 
     // check RAW dependency
-    int prior = rob_index - 1;
-    if (prior < 0)
-        prior = ROB.SIZE - 1;
-
-    if (rob_index != ROB.head) {
-        if ((int)ROB.head <= prior) {
-            for (int i=prior; i>=(int)ROB.head; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
-        } else {
-            for (int i=prior; i>=0; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
-            for (int i=ROB.SIZE-1; i>=(int)ROB.head; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
+    // a source depends on the youngest older instruction writing its register that has not executed yet
+    uint32_t oldest = UINT32_MAX;
+    for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
+        if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0)) {
+            uint32_t producer = find_reg_producer(&ROB.entry[rob_index].source_writer[j], ROB.entry[rob_index].source_registers[j]);
+            if (producer == UINT32_MAX)
+                continue;
+
+            reg_RAW_dependency(producer, rob_index, j);
+            if ((oldest == UINT32_MAX) || (ROB.entry[producer].instr_id < ROB.entry[oldest].instr_id))
+                oldest = producer;
         }
     }
+
+    // the oldest producer is the one recorded
+    if (oldest != UINT32_MAX)
+        ROB.entry[rob_index].producer_id = ROB.entry[oldest].instr_id;
+}
+
+uint8_t O3_CPU::in_rob(const ROB_WRITER &writer)
+{
+    return (writer.rob_index < ROB.SIZE) && ROB.entry[writer.rob_index].ip && (ROB.entry[writer.rob_index].instr_id == writer.instr_id);
+}
+
+// follows the writers of a register back from the given link to the first one that has not executed yet,
+// UINT32_MAX if all of them executed or retired. executed writers stay executed, so the links that
+// were passed are pointed straight at the result for the next lookup
+uint32_t O3_CPU::find_reg_producer(ROB_WRITER *link, uint8_t reg)
+{
+    ROB_WRITER *first = link;
+    uint32_t producer = UINT32_MAX;
+
+    while (in_rob(*link)) {
+        uint32_t i = link->rob_index;
+        if (ROB.entry[i].executed != COMPLETED) {
+            producer = i;
+            break;
+        }
+
+        // the prior writer is kept with the first destination naming the register
+        uint32_t k = 0;
+        while (ROB.entry[i].destination_registers[k] != reg)
+            k++;
+        link = &ROB.entry[i].prior_writer[k];
+    }
+
+    ROB_WRITER found;
+    if (producer != UINT32_MAX)
+        found = *link;
+
+    while (first != link) {
+        uint32_t i = first->rob_index, k = 0;
+        while (ROB.entry[i].destination_registers[k] != reg)
+            k++;
+
+        *first = found;
+        first = &ROB.entry[i].prior_writer[k];
+    }
+
+    return producer;
 }
 
 void O3_CPU::reg_RAW_dependency(uint32_t prior, uint32_t current, uint32_t source_index)
@@ -695,14 +764,14 @@ void O3_CPU::execute_instruction()
     uint32_t exec_issued = 0, num_iteration = 0;
 
     while (exec_issued < EXEC_WIDTH) {
-        if (RTE0[RTE0_head] < ROB_SIZE) {
+        if (RTE0[RTE0_head] < ROB.SIZE) {
             uint32_t exec_index = RTE0[RTE0_head];
             if (ROB.entry[exec_index].event_cycle <= current_core_cycle[cpu]) {
                 do_execution(exec_index);
 
-                RTE0[RTE0_head] = ROB_SIZE;
+                RTE0[RTE0_head] = ROB.SIZE;
                 RTE0_head++;
-                if (RTE0_head == ROB_SIZE)
+                if (RTE0_head == ROB.SIZE)
                     RTE0_head = 0;
                 exec_issued++;
             }
@@ -714,20 +783,20 @@ void O3_CPU::execute_instruction()
         }
 
         num_iteration++;
-        if (num_iteration == (ROB_SIZE-1))
+        if (num_iteration == (ROB.SIZE-1))
             break;
     }
 
     num_iteration = 0;
     while (exec_issued < EXEC_WIDTH) {
-        if (RTE1[RTE1_head] < ROB_SIZE) {
+        if (RTE1[RTE1_head] < ROB.SIZE) {
             uint32_t exec_index = RTE1[RTE1_head];
             if (ROB.entry[exec_index].event_cycle <= current_core_cycle[cpu]) {
                 do_execution(exec_index);
 
-                RTE1[RTE1_head] = ROB_SIZE;
+                RTE1[RTE1_head] = ROB.SIZE;
                 RTE1_head++;
-                if (RTE1_head == ROB_SIZE)
+                if (RTE1_head == ROB.SIZE)
                     RTE1_head = 0;
                 exec_issued++;
             }
@@ -739,7 +808,7 @@ void O3_CPU::execute_instruction()
         }
 
         num_iteration++;
-        if (num_iteration == (ROB_SIZE-1))
+        if (num_iteration == (ROB.SIZE-1))
             break;
     }
 }
@@ -752,11 +821,12 @@ void O3_CPU::do_execution(uint32_t rob_index)
 
         // ADD LATENCY
         if (ROB.entry[rob_index].event_cycle < current_core_cycle[cpu])
-            ROB.entry[rob_index].event_cycle = current_core_cycle[cpu] + EXEC_LATENCY;
+            set_event_cycle(rob_index, current_core_cycle[cpu] + EXEC_LATENCY);
         else
-            ROB.entry[rob_index].event_cycle += EXEC_LATENCY;
+            set_event_cycle(rob_index, ROB.entry[rob_index].event_cycle + EXEC_LATENCY);
 
         inflight_reg_executions++;
+        wake_completion(rob_index);
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " non-memory instr_id: " << ROB.entry[rob_index].instr_id; 
@@ -770,44 +840,25 @@ void O3_CPU::schedule_memory_instruction()
         return;
 
     // execution is out-of-order but we have an in-order scheduling algorithm to detect all RAW dependencies
-    uint32_t limit = ROB.next_schedule;
+    // the scan over the scheduled window stops at the first memory instruction that is not ready,
+    // up to there only the instructions woken up by their producers are visited, in ROB order
+    uint32_t window = scheduled_window(), n = 0;
     num_searched = 0;
-    if (ROB.head < limit) {
-        for (uint32_t i=ROB.head; i<limit; i++) {
-
-            if (ROB.entry[i].is_memory == 0)
-                continue;
-
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                break;
-
-            if (ROB.entry[i].is_memory && ROB.entry[i].reg_ready && (ROB.entry[i].scheduled == INFLIGHT))
-                do_memory_scheduling(i);
-        }
-    }
-    else {
-        for (uint32_t i=ROB.head; i<ROB.SIZE; i++) {
-
-            if (ROB.entry[i].is_memory == 0)
-                continue;
-
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                break;
-
-            if (ROB.entry[i].is_memory && ROB.entry[i].reg_ready && (ROB.entry[i].scheduled == INFLIGHT))
-                do_memory_scheduling(i);
-        }
-        for (uint32_t i=0; i<limit; i++) {
+    while (n < window) {
+        uint32_t ready = find_in_window(memory_ready, n, window);
+        if (ready == window)
+            break;
 
-            if (ROB.entry[i].is_memory == 0)
-                continue;
+        if ((find_later_in_window(memory_event, n, ready+1, current_core_cycle[cpu]) <= ready) || (num_searched >= SCHEDULER_SIZE))
+            break;
 
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                break;
+        uint32_t i = (ROB.head + ready) % ROB.SIZE;
+        if (ROB.entry[i].reg_ready && (ROB.entry[i].scheduled == INFLIGHT))
+            do_memory_scheduling(i);
+        if ((ROB.entry[i].reg_ready == 0) || (ROB.entry[i].scheduled != INFLIGHT))
+            memory_ready.erase(i);
 
-            if (ROB.entry[i].is_memory && ROB.entry[i].reg_ready && (ROB.entry[i].scheduled == INFLIGHT))
-                do_memory_scheduling(i);
-        }
+        n = ready + 1;
     }
 }
 
@@ -824,6 +875,7 @@ void O3_CPU::do_memory_scheduling(uint32_t rob_index)
         ROB.entry[rob_index].scheduled = COMPLETED;
         if (ROB.entry[rob_index].executed == 0) // it could be already set to COMPLETED due to store-to-load forwarding
             ROB.entry[rob_index].executed  = INFLIGHT;
+        wake_completion(rob_index);
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " instr_id: " << ROB.entry[rob_index].instr_id << " rob_index: " << rob_index;
@@ -892,13 +944,7 @@ uint32_t O3_CPU::check_and_add_lsq(uint32_t rob_index)
 void O3_CPU::add_load_queue(uint32_t rob_index, uint32_t data_index)
 {
     // search for an empty slot 
-    uint32_t lq_index = LQ.SIZE;
-    for (uint32_t i=0; i<LQ.SIZE; i++) {
-        if (LQ.entry[i].virtual_address == 0) {
-            lq_index = i;
-            break;
-        }
-    }
+    uint32_t lq_index = lq_free.find(0, LQ.SIZE);
 
     // sanity check
     if (lq_index == LQ.SIZE) {
@@ -917,86 +963,27 @@ void O3_CPU::add_load_queue(uint32_t rob_index, uint32_t data_index)
     LQ.entry[lq_index].asid[1] = ROB.entry[rob_index].asid[1];
     LQ.entry[lq_index].event_cycle = current_core_cycle[cpu] + SCHEDULING_LATENCY;
     LQ.occupancy++;
+    lq_free.erase(lq_index);
 
     // check RAW dependency
-    int prior = rob_index - 1;
-    if (prior < 0)
-        prior = ROB.SIZE - 1;
-
-    if (rob_index != ROB.head) {
-        if ((int)ROB.head <= prior) {
-            for (int i=prior; i>=(int)ROB.head; i--) {
-                if (LQ.entry[lq_index].producer_id != UINT64_MAX)
-                {
-                    break;
-                }
-
-                    mem_RAW_dependency(i, rob_index, data_index, lq_index);
-            }
-        }
-        else {
-            for (int i=prior; i>=0; i--) {
-                if (LQ.entry[lq_index].producer_id != UINT64_MAX)
-                {
-                    break;
-                }
-
-                    mem_RAW_dependency(i, rob_index, data_index, lq_index);
-            }
-            for (int i=ROB.SIZE-1; i>=(int)ROB.head; i--) { 
-                if (LQ.entry[lq_index].producer_id != UINT64_MAX)
-                {
-                    break;
-                }
-
-                    mem_RAW_dependency(i, rob_index, data_index, lq_index);
-            }
-        }
-    }
+    // the youngest older store to the address was looked up by add_to_rob(), if it is still in the ROB it is the producer
+    const ROB_WRITER &store = ROB.entry[rob_index].source_store[data_index];
+    if (in_rob(store))
+        mem_RAW_dependency(store.rob_index, rob_index, data_index, lq_index);
 
     // check
     // 1) if store-to-load forwarding is possible
     // 2) if there is WAR that are not correctly executed
+    // forwarding is done by the SQ entry of the producer from the RAW dependency check, if it is in the SQ already.
+    // without a producer, a store to the same address found in the SQ is logically later in the program order
+    // but already executed => this is WAR, not RAW. thanks to the store buffer and in-order retirement its data
+    // does not reach the memory system before this load, so the load just reads the data cache, as its
+    // LQ entry is left untranslated and unfetched
     uint32_t forwarding_index = SQ.SIZE;
-    for (uint32_t i=0; i<SQ.SIZE; i++) {
-
-        // skip empty slot
-        if (SQ.entry[i].virtual_address == 0)
-            continue;
-
-        // forwarding should be done by the SQ entry that holds the same producer_id from RAW dependency check
-        if (SQ.entry[i].virtual_address == LQ.entry[lq_index].virtual_address) { // store-to-load forwarding check
-
-            // forwarding store is in the SQ
-            if ((rob_index != ROB.head) && (LQ.entry[lq_index].producer_id == SQ.entry[i].instr_id)) { // RAW
-                forwarding_index = i;
-                break; // should be break
-            }
-
-            if ((LQ.entry[lq_index].producer_id == UINT64_MAX) && (LQ.entry[lq_index].instr_id <= SQ.entry[i].instr_id)) { // WAR 
-                // a load is about to be added in the load queue and we found a store that is 
-                // "logically later in the program order but already executed" => this is not correctly executed WAR
-                // due to out-of-order execution, this case is possible, for example
-                // 1) application is load intensive and load queue is full
-                // 2) we have loads that can't be added in the load queue
-                // 3) subsequent stores logically behind in the program order are added in the store queue first
-
-                // thanks to the store buffer, data is not written back to the memory system until retirement
-                // also due to in-order retirement, this "already executed store" cannot be retired until we finish the prior load instruction 
-                // if we detect WAR when a load is added in the load queue, just let the load instruction to access the memory system
-                // no need to mark any dependency because this is actually WAR not RAW
-
-                // do not forward data from the store queue since this is WAR
-                // just read correct data from data cache
-
-                LQ.entry[lq_index].physical_address = 0;
-                LQ.entry[lq_index].translated = 0;
-                LQ.entry[lq_index].fetched = 0;
-                
-                DP(if(warmup_complete[cpu]) {
-                cout << "[LQ] " << __func__ << " instr_id: " << LQ.entry[lq_index].instr_id << " reset fetched: " << +LQ.entry[lq_index].fetched;
-                cout << " to obey WAR store instr_id: " << SQ.entry[i].instr_id << " cycle: " << current_core_cycle[cpu] << endl; });
-            }
+    if (LQ.entry[lq_index].producer_id != UINT64_MAX) {
+        for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+            if ((ROB.entry[store.rob_index].destination_memory[i] == LQ.entry[lq_index].virtual_address) && (ROB.entry[store.rob_index].sq_index[i] < forwarding_index))
+                forwarding_index = ROB.entry[store.rob_index].sq_index[i];
         }
     }
 
@@ -1009,13 +996,15 @@ void O3_CPU::add_load_queue(uint32_t rob_index, uint32_t data_index)
 
             uint32_t fwr_rob_index = LQ.entry[lq_index].rob_index;
             ROB.entry[fwr_rob_index].num_mem_ops--;
-            ROB.entry[fwr_rob_index].event_cycle = current_core_cycle[cpu];
+            set_event_cycle(fwr_rob_index, current_core_cycle[cpu]);
             if (ROB.entry[fwr_rob_index].num_mem_ops < 0) {
                 cerr << "instr_id: " << ROB.entry[fwr_rob_index].instr_id << endl;
                 assert(0);
             }
-            if (ROB.entry[fwr_rob_index].num_mem_ops == 0)
+            if (ROB.entry[fwr_rob_index].num_mem_ops == 0) {
                 inflight_mem_executions++;
+                wake_completion(fwr_rob_index);
+            }
 
             DP(if(warmup_complete[cpu]) {
             cout << "[LQ] " << __func__ << " instr_id: " << LQ.entry[lq_index].instr_id << hex;
@@ -1034,7 +1023,7 @@ void O3_CPU::add_load_queue(uint32_t rob_index, uint32_t data_index)
     if (LQ.entry[lq_index].virtual_address && (LQ.entry[lq_index].producer_id == UINT64_MAX)) { // not released and no forwarding
         RTL0[RTL0_tail] = lq_index;
         RTL0_tail++;
-        if (RTL0_tail == LQ_SIZE)
+        if (RTL0_tail == LQ.SIZE)
             RTL0_tail = 0;
 
         DP (if (warmup_complete[cpu]) {
@@ -1122,7 +1111,7 @@ void O3_CPU::add_store_queue(uint32_t rob_index, uint32_t data_index)
 
     RTS0[RTS0_tail] = sq_index;
     RTS0_tail++;
-    if (RTS0_tail == SQ_SIZE)
+    if (RTS0_tail == SQ.SIZE)
         RTS0_tail = 0;
 
     DP(if(warmup_complete[cpu]) {
@@ -1137,7 +1126,7 @@ void O3_CPU::operate_lsq()
     uint32_t store_issued = 0, num_iteration = 0;
 
     while (store_issued < SQ_WIDTH) {
-        if (RTS0[RTS0_head] < SQ_SIZE) {
+        if (RTS0[RTS0_head] < SQ.SIZE) {
             uint32_t sq_index = RTS0[RTS0_head];
             if (SQ.entry[sq_index].event_cycle <= current_core_cycle[cpu]) {
 
@@ -1147,7 +1136,6 @@ void O3_CPU::operate_lsq()
                 data_packet.tlb_access = 1;
                 data_packet.fill_level = FILL_L1;
                 data_packet.cpu = cpu;
-                data_packet.data_index = SQ.entry[sq_index].data_index;
                 data_packet.sq_index = sq_index;
                 if (knob_cloudsuite)
                     data_packet.address = ((SQ.entry[sq_index].virtual_address >> LOG2_PAGE_SIZE) << 9) | SQ.entry[sq_index].asid[1];
@@ -1173,9 +1161,9 @@ void O3_CPU::operate_lsq()
                 else 
                     SQ.entry[sq_index].translated = INFLIGHT;
 
-                RTS0[RTS0_head] = SQ_SIZE;
+                RTS0[RTS0_head] = SQ.SIZE;
                 RTS0_head++;
-                if (RTS0_head == SQ_SIZE)
+                if (RTS0_head == SQ.SIZE)
                     RTS0_head = 0;
 
                 store_issued++;
@@ -1188,20 +1176,20 @@ void O3_CPU::operate_lsq()
         }
 
         num_iteration++;
-        if (num_iteration == (SQ_SIZE-1))
+        if (num_iteration == (SQ.SIZE-1))
             break;
     }
 
     num_iteration = 0;
     while (store_issued < SQ_WIDTH) {
-        if (RTS1[RTS1_head] < SQ_SIZE) {
+        if (RTS1[RTS1_head] < SQ.SIZE) {
             uint32_t sq_index = RTS1[RTS1_head];
             if (SQ.entry[sq_index].event_cycle <= current_core_cycle[cpu]) {
                 execute_store(SQ.entry[sq_index].rob_index, sq_index, SQ.entry[sq_index].data_index);
 
-                RTS1[RTS1_head] = SQ_SIZE;
+                RTS1[RTS1_head] = SQ.SIZE;
                 RTS1_head++;
-                if (RTS1_head == SQ_SIZE)
+                if (RTS1_head == SQ.SIZE)
                     RTS1_head = 0;
 
                 store_issued++;
@@ -1214,14 +1202,14 @@ void O3_CPU::operate_lsq()
         }
 
         num_iteration++;
-        if (num_iteration == (SQ_SIZE-1))
+        if (num_iteration == (SQ.SIZE-1))
             break;
     }
 
     unsigned load_issued = 0;
     num_iteration = 0;
     while (load_issued < LQ_WIDTH) {
-        if (RTL0[RTL0_head] < LQ_SIZE) {
+        if (RTL0[RTL0_head] < LQ.SIZE) {
             uint32_t lq_index = RTL0[RTL0_head];
             if (LQ.entry[lq_index].event_cycle <= current_core_cycle[cpu]) {
 
@@ -1229,7 +1217,6 @@ void O3_CPU::operate_lsq()
                 PACKET data_packet;
                 data_packet.fill_level = FILL_L1;
                 data_packet.cpu = cpu;
-                data_packet.data_index = LQ.entry[lq_index].data_index;
                 data_packet.lq_index = lq_index;
                 if (knob_cloudsuite)
                     data_packet.address = ((LQ.entry[lq_index].virtual_address >> LOG2_PAGE_SIZE) << 9) | LQ.entry[lq_index].asid[1];
@@ -1255,9 +1242,9 @@ void O3_CPU::operate_lsq()
                 else  
                     LQ.entry[lq_index].translated = INFLIGHT;
 
-                RTL0[RTL0_head] = LQ_SIZE;
+                RTL0[RTL0_head] = LQ.SIZE;
                 RTL0_head++;
-                if (RTL0_head == LQ_SIZE)
+                if (RTL0_head == LQ.SIZE)
                     RTL0_head = 0;
 
                 load_issued++;
@@ -1270,21 +1257,21 @@ void O3_CPU::operate_lsq()
         }
 
         num_iteration++;
-        if (num_iteration == (LQ_SIZE-1))
+        if (num_iteration == (LQ.SIZE-1))
             break;
     }
 
     num_iteration = 0;
     while (load_issued < LQ_WIDTH) {
-        if (RTL1[RTL1_head] < LQ_SIZE) {
+        if (RTL1[RTL1_head] < LQ.SIZE) {
             uint32_t lq_index = RTL1[RTL1_head];
             if (LQ.entry[lq_index].event_cycle <= current_core_cycle[cpu]) {
                 int rq_index = execute_load(LQ.entry[lq_index].rob_index, lq_index, LQ.entry[lq_index].data_index);
 
                 if (rq_index != -2) {
-                    RTL1[RTL1_head] = LQ_SIZE;
+                    RTL1[RTL1_head] = LQ.SIZE;
                     RTL1_head++;
-                    if (RTL1_head == LQ_SIZE)
+                    if (RTL1_head == LQ.SIZE)
                         RTL1_head = 0;
 
                     load_issued++;
@@ -1298,7 +1285,7 @@ void O3_CPU::operate_lsq()
         }
 
         num_iteration++;
-        if (num_iteration == (LQ_SIZE-1))
+        if (num_iteration == (LQ.SIZE-1))
             break;
     }
 }
@@ -1309,13 +1296,15 @@ void O3_CPU::execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_
     SQ.entry[sq_index].event_cycle = current_core_cycle[cpu];
 
     ROB.entry[rob_index].num_mem_ops--;
-    ROB.entry[rob_index].event_cycle = current_core_cycle[cpu];
+    set_event_cycle(rob_index, current_core_cycle[cpu]);
     if (ROB.entry[rob_index].num_mem_ops < 0) {
         cerr << "instr_id: " << ROB.entry[rob_index].instr_id << endl;
         assert(0);
     }
-    if (ROB.entry[rob_index].num_mem_ops == 0)
+    if (ROB.entry[rob_index].num_mem_ops == 0) {
         inflight_mem_executions++;
+        wake_completion(rob_index);
+    }
 
     DP (if (warmup_complete[cpu]) {
     cout << "[SQ1] " << __func__ << " instr_id: " << SQ.entry[sq_index].instr_id << hex;
@@ -1325,7 +1314,7 @@ void O3_CPU::execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_
     // resolve RAW dependency after DTLB access
     // check if this store has dependent loads
     if (ROB.entry[rob_index].is_producer) {
-	ITERATE_SET(dependent,ROB.entry[rob_index].memory_instrs_depend_on_me, ROB_SIZE) {
+	ITERATE_SET(dependent,ROB.entry[rob_index].memory_instrs_depend_on_me, ROB.SIZE) {
             // check if dependent loads are already added in the load queue
             for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) { // which one is dependent?
                 if (ROB.entry[dependent].source_memory[j] && ROB.entry[dependent].source_added[j]) {
@@ -1350,15 +1339,17 @@ void O3_CPU::execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_
 
                         uint32_t fwr_rob_index = LQ.entry[lq_index].rob_index;
                         ROB.entry[fwr_rob_index].num_mem_ops--;
-                        ROB.entry[fwr_rob_index].event_cycle = current_core_cycle[cpu];
+                        set_event_cycle(fwr_rob_index, current_core_cycle[cpu]);
 #ifdef SANITY_CHECK
                         if (ROB.entry[fwr_rob_index].num_mem_ops < 0) {
                             cerr << "instr_id: " << ROB.entry[fwr_rob_index].instr_id << endl;
                             assert(0);
                         }
 #endif
-                        if (ROB.entry[fwr_rob_index].num_mem_ops == 0)
+                        if (ROB.entry[fwr_rob_index].num_mem_ops == 0) {
                             inflight_mem_executions++;
+                            wake_completion(fwr_rob_index);
+                        }
 
                         DP(if(warmup_complete[cpu]) {
                         cout << "[LQ3] " << __func__ << " instr_id: " << LQ.entry[lq_index].instr_id << hex;
@@ -1383,7 +1374,6 @@ int O3_CPU::execute_load(uint32_t rob_index, uint32_t lq_index, uint32_t data_in
     PACKET data_packet;
     data_packet.fill_level = FILL_L1;
     data_packet.cpu = cpu;
-    data_packet.data_index = LQ.entry[lq_index].data_index;
     data_packet.lq_index = lq_index;
     data_packet.address = LQ.entry[lq_index].physical_address >> LOG2_BLOCK_SIZE;
     data_packet.full_addr = LQ.entry[lq_index].physical_address;
@@ -1458,20 +1448,22 @@ void O3_CPU::reg_RAW_release(uint32_t rob_index)
 {
     // if (!ROB.entry[rob_index].registers_instrs_depend_on_me.empty()) 
 
-    ITERATE_SET(i,ROB.entry[rob_index].registers_instrs_depend_on_me, ROB_SIZE) {
+    ITERATE_SET(i,ROB.entry[rob_index].registers_instrs_depend_on_me, ROB.SIZE) {
         for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
             if (ROB.entry[rob_index].registers_index_depend_on_me[j].search (i)) {
                 ROB.entry[i].num_reg_dependent--;
 
                 if (ROB.entry[i].num_reg_dependent == 0) {
                     ROB.entry[i].reg_ready = 1;
-                    if (ROB.entry[i].is_memory)
+                    if (ROB.entry[i].is_memory) {
                         ROB.entry[i].scheduled = INFLIGHT;
+                        memory_ready.insert(i);
+                    }
                     else {
                         ROB.entry[i].scheduled = COMPLETED;
 
 #ifdef SANITY_CHECK
-                        if (RTE0[RTE0_tail] < ROB_SIZE)
+                        if (RTE0[RTE0_tail] < ROB.SIZE)
                             assert(0);
 #endif
                         // remember this rob_index in the Ready-To-Execute array 0
@@ -1482,7 +1474,7 @@ void O3_CPU::reg_RAW_release(uint32_t rob_index)
                         cout << " head: " << RTE0_head << " tail: " << RTE0_tail << endl; }); 
 
                         RTE0_tail++;
-                        if (RTE0_tail == ROB_SIZE)
+                        if (RTE0_tail == ROB.SIZE)
                             RTE0_tail = 0;
 
                     }
@@ -1506,6 +1498,73 @@ void O3_CPU::operate_cache()
     L2C.operate();
 }
 
+// every change to the event cycle of a ROB entry goes through here to keep the trees up to date
+void O3_CPU::set_event_cycle(uint32_t rob_index, uint64_t cycle)
+{
+    ROB.entry[rob_index].event_cycle = cycle;
+    rob_event.update(rob_index, cycle);
+    if (ROB.entry[rob_index].is_memory)
+        memory_event.update(rob_index, cycle);
+}
+
+// an instruction can complete once it executes and, for memory instructions, all of its memory operations are done
+void O3_CPU::wake_completion(uint32_t rob_index)
+{
+    if ((ROB.entry[rob_index].executed == INFLIGHT) && ((ROB.entry[rob_index].is_memory == 0) || (ROB.entry[rob_index].num_mem_ops == 0)))
+        completing.insert(rob_index);
+}
+
+// number of entries from the head that have been scheduled
+uint32_t O3_CPU::scheduled_window()
+{
+    uint32_t window = (ROB.head <= ROB.next_schedule) ? (ROB.next_schedule - ROB.head) : (ROB.SIZE - ROB.head + ROB.next_schedule);
+
+    // next_schedule wraps around to the head once the whole ROB is scheduled
+    if ((window == 0) && ROB.occupancy && ROB.entry[ROB.head].scheduled)
+        window = ROB.SIZE;
+
+    return window;
+}
+
+// the window searches take and return positions counted from the ROB head, end if nothing is found
+uint32_t O3_CPU::find_in_window(INDEX_SET &set, uint32_t begin, uint32_t end)
+{
+    if (begin >= end)
+        return end;
+
+    uint32_t first = ROB.head + begin, last = ROB.head + end;
+    if (first < ROB.SIZE) {
+        uint32_t stop = (last < ROB.SIZE) ? last : ROB.SIZE,
+                 found = set.find(first, stop);
+        if (found < stop)
+            return found - ROB.head;
+        if (last <= ROB.SIZE)
+            return end;
+        first = ROB.SIZE;
+    }
+
+    return set.find(first - ROB.SIZE, last - ROB.SIZE) + ROB.SIZE - ROB.head;
+}
+
+uint32_t O3_CPU::find_later_in_window(ROB_CYCLE_TREE &tree, uint32_t begin, uint32_t end, uint64_t cycle)
+{
+    if (begin >= end)
+        return end;
+
+    uint32_t first = ROB.head + begin, last = ROB.head + end;
+    if (first < ROB.SIZE) {
+        uint32_t stop = (last < ROB.SIZE) ? last : ROB.SIZE,
+                 found = tree.find_later(first, stop, cycle);
+        if (found < stop)
+            return found - ROB.head;
+        if (last <= ROB.SIZE)
+            return end;
+        first = ROB.SIZE;
+    }
+
+    return tree.find_later(first - ROB.SIZE, last - ROB.SIZE, cycle) + ROB.SIZE - ROB.head;
+}
+
 void O3_CPU::update_rob()
 {
     if (ITLB.PROCESSED.occupancy && (ITLB.PROCESSED.entry[ITLB.PROCESSED.head].event_cycle <= current_core_cycle[cpu]))
@@ -1520,17 +1579,13 @@ void O3_CPU::update_rob()
     if (L1D.PROCESSED.occupancy && (L1D.PROCESSED.entry[L1D.PROCESSED.head].event_cycle <= current_core_cycle[cpu]))
         complete_data_fetch(&L1D.PROCESSED, 0);
 
-    // update ROB entries with completed executions
+    // update ROB entries with completed executions, in ROB order
     if ((inflight_reg_executions > 0) || (inflight_mem_executions > 0)) {
-        if (ROB.head < ROB.tail) {
-            for (uint32_t i=ROB.head; i<ROB.tail; i++) 
-                complete_execution(i);
-        }
-        else {
-            for (uint32_t i=ROB.head; i<ROB.SIZE; i++)
-                complete_execution(i);
-            for (uint32_t i=0; i<ROB.tail; i++)
-                complete_execution(i);
+        for (uint32_t n=find_in_window(completing, 0, ROB.occupancy); n<ROB.occupancy; n=find_in_window(completing, n+1, ROB.occupancy)) {
+            uint32_t i = (ROB.head + n) % ROB.SIZE;
+            complete_execution(i);
+            if (ROB.entry[i].executed == COMPLETED)
+                completing.erase(i);
         }
     }
 }
@@ -1553,7 +1608,7 @@ void O3_CPU::complete_instr_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
     }
     else
         ROB.entry[rob_index].fetched = COMPLETED;
-    ROB.entry[rob_index].event_cycle = current_core_cycle[cpu];
+    set_event_cycle(rob_index, current_core_cycle[cpu]);
     num_fetched++;
 
     DP ( if (warmup_complete[cpu]) {
@@ -1564,7 +1619,7 @@ void O3_CPU::complete_instr_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
 
     // check if other instructions were merged
     if (queue->entry[index].instr_merged) {
-	ITERATE_SET(i,queue->entry[index].rob_index_depend_on_me, ROB_SIZE) {
+	ITERATE_SET(i,queue->entry[index].depend_on_me.sets->rob_index_depend_on_me, ROB.SIZE) {
             // update ROB entry
             if (is_it_tlb) {
                 ROB.entry[i].translated = COMPLETED;
@@ -1572,7 +1627,7 @@ void O3_CPU::complete_instr_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
             }
             else
                 ROB.entry[i].fetched = COMPLETED;
-            ROB.entry[i].event_cycle = current_core_cycle[cpu] + (num_fetched / FETCH_WIDTH);
+            set_event_cycle(i, current_core_cycle[cpu] + (num_fetched / FETCH_WIDTH));
             num_fetched++;
 
             DP ( if (warmup_complete[cpu]) {
@@ -1611,7 +1666,7 @@ void O3_CPU::complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
 
             RTS1[RTS1_tail] = sq_index;
             RTS1_tail++;
-            if (RTS1_tail == SQ_SIZE)
+            if (RTS1_tail == SQ.SIZE)
                 RTS1_tail = 0;
 
             DP (if (warmup_complete[cpu]) {
@@ -1629,7 +1684,7 @@ void O3_CPU::complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
 
             RTL1[RTL1_tail] = lq_index;
             RTL1_tail++;
-            if (RTL1_tail == LQ_SIZE)
+            if (RTL1_tail == LQ.SIZE)
                 RTL1_tail = 0;
 
             DP (if (warmup_complete[cpu]) {
@@ -1645,7 +1700,7 @@ void O3_CPU::complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
             handle_merged_translation(&queue->entry[index]);
         }
 
-        ROB.entry[rob_index].event_cycle = queue->entry[index].event_cycle;
+        set_event_cycle(rob_index, queue->entry[index].event_cycle);
     }
     else { // L1D
 
@@ -1659,7 +1714,7 @@ void O3_CPU::complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
             LQ.entry[lq_index].fetched = COMPLETED;
             LQ.entry[lq_index].event_cycle = current_core_cycle[cpu];
             ROB.entry[rob_index].num_mem_ops--;
-            ROB.entry[rob_index].event_cycle = queue->entry[index].event_cycle;
+            set_event_cycle(rob_index, queue->entry[index].event_cycle);
 
 #ifdef SANITY_CHECK
             if (ROB.entry[rob_index].num_mem_ops < 0) {
@@ -1667,8 +1722,10 @@ void O3_CPU::complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
                 assert(0);
             }
 #endif
-            if (ROB.entry[rob_index].num_mem_ops == 0)
+            if (ROB.entry[rob_index].num_mem_ops == 0) {
                 inflight_mem_executions++;
+                wake_completion(rob_index);
+            }
 
             DP (if (warmup_complete[cpu]) {
             cout << "[ROB] " << __func__ << " load instr_id: " << LQ.entry[lq_index].instr_id;
@@ -1704,7 +1761,7 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
 
             RTS1[RTS1_tail] = sq_index;
             RTS1_tail++;
-            if (RTS1_tail == SQ_SIZE)
+            if (RTS1_tail == SQ.SIZE)
                 RTS1_tail = 0;
 
             DP (if (warmup_complete[cpu]) {
@@ -1721,7 +1778,7 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
 
             RTL1[RTL1_tail] = lq_index;
             RTL1_tail++;
-            if (RTL1_tail == LQ_SIZE)
+            if (RTL1_tail == LQ.SIZE)
                 RTL1_tail = 0;
 
             DP (if (warmup_complete[cpu]) {
@@ -1737,7 +1794,7 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
             handle_merged_translation(current_packet);
         }
 
-        ROB.entry[rob_index].event_cycle = current_packet->event_cycle;
+        set_event_cycle(rob_index, current_packet->event_cycle);
     }
     else { // L1D
 
@@ -1760,8 +1817,10 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
                 assert(0);
             }
 #endif
-            if (ROB.entry[rob_index].num_mem_ops == 0)
+            if (ROB.entry[rob_index].num_mem_ops == 0) {
                 inflight_mem_executions++;
+                wake_completion(rob_index);
+            }
 
             DP (if (warmup_complete[cpu]) {
             cout << "[ROB] " << __func__ << " load instr_id: " << LQ.entry[lq_index].instr_id;
@@ -1773,7 +1832,7 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
 
             handle_merged_load(current_packet);
 
-            ROB.entry[rob_index].event_cycle = current_packet->event_cycle;
+            set_event_cycle(rob_index, current_packet->event_cycle);
         }
     }
 }
@@ -1781,14 +1840,14 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
 void O3_CPU::handle_merged_translation(PACKET *provider)
 {
     if (provider->store_merged) {
-	ITERATE_SET(merged, provider->sq_index_depend_on_me, SQ.SIZE) {
+	ITERATE_SET(merged, provider->depend_on_me.sets->sq_index_depend_on_me, SQ.SIZE) {
             SQ.entry[merged].translated = COMPLETED;
             SQ.entry[merged].physical_address = (provider->data_pa << LOG2_PAGE_SIZE) | (SQ.entry[merged].virtual_address & ((1 << LOG2_PAGE_SIZE) - 1)); // translated address
             SQ.entry[merged].event_cycle = current_core_cycle[cpu];
 
             RTS1[RTS1_tail] = merged;
             RTS1_tail++;
-            if (RTS1_tail == SQ_SIZE)
+            if (RTS1_tail == SQ.SIZE)
                 RTS1_tail = 0;
 
             DP (if (warmup_complete[cpu]) {
@@ -1798,14 +1857,14 @@ void O3_CPU::handle_merged_translation(PACKET *provider)
         }
     }
     if (provider->load_merged) {
-	ITERATE_SET(merged, provider->lq_index_depend_on_me, LQ.SIZE) {
+	ITERATE_SET(merged, provider->depend_on_me.sets->lq_index_depend_on_me, LQ.SIZE) {
             LQ.entry[merged].translated = COMPLETED;
             LQ.entry[merged].physical_address = (provider->data_pa << LOG2_PAGE_SIZE) | (LQ.entry[merged].virtual_address & ((1 << LOG2_PAGE_SIZE) - 1)); // translated address
             LQ.entry[merged].event_cycle = current_core_cycle[cpu];
 
             RTL1[RTL1_tail] = merged;
             RTL1_tail++;
-            if (RTL1_tail == LQ_SIZE)
+            if (RTL1_tail == LQ.SIZE)
                 RTL1_tail = 0;
 
             DP (if (warmup_complete[cpu]) {
@@ -1822,13 +1881,17 @@ void O3_CPU::handle_merged_translation(PACKET *provider)
 
 void O3_CPU::handle_merged_load(PACKET *provider)
 {
-    ITERATE_SET(merged, provider->lq_index_depend_on_me, LQ.SIZE) {
+    // no load was merged into the packet
+    if (provider->depend_on_me.sets == NULL)
+        return;
+
+    ITERATE_SET(merged, provider->depend_on_me.sets->lq_index_depend_on_me, LQ.SIZE) {
         uint32_t merged_rob_index = LQ.entry[merged].rob_index;
 
         LQ.entry[merged].fetched = COMPLETED;
         LQ.entry[merged].event_cycle = current_core_cycle[cpu];
         ROB.entry[merged_rob_index].num_mem_ops--;
-        ROB.entry[merged_rob_index].event_cycle = current_core_cycle[cpu];
+        set_event_cycle(merged_rob_index, current_core_cycle[cpu]);
 
 #ifdef SANITY_CHECK
         if (ROB.entry[merged_rob_index].num_mem_ops < 0) {
@@ -1837,8 +1900,10 @@ void O3_CPU::handle_merged_load(PACKET *provider)
         }
 #endif
 
-        if (ROB.entry[merged_rob_index].num_mem_ops == 0)
+        if (ROB.entry[merged_rob_index].num_mem_ops == 0) {
             inflight_mem_executions++;
+            wake_completion(merged_rob_index);
+        }
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " load instr_id: " << LQ.entry[merged].instr_id;
@@ -1859,6 +1924,7 @@ void O3_CPU::release_load_queue(uint32_t lq_index)
 
     LSQ_ENTRY empty_entry;
     LQ.entry[lq_index] = empty_entry;
+    lq_free.insert(lq_index);
     LQ.occupancy--;
 }
 
@@ -1894,7 +1960,6 @@ void O3_CPU::retire_rob()
                         // but we pass this information to avoid segmentation fault
                         data_packet.fill_level = FILL_L1;
                         data_packet.cpu = cpu;
-                        data_packet.data_index = SQ.entry[sq_index].data_index;
                         data_packet.sq_index = sq_index;
                         data_packet.address = SQ.entry[sq_index].physical_address >> LOG2_BLOCK_SIZE;
                         data_packet.full_addr = SQ.entry[sq_index].physical_address;
@@ -1945,8 +2010,21 @@ void O3_CPU::retire_rob()
         DP ( if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " instr_id: " << ROB.entry[ROB.head].instr_id << " is retired" << endl; });
 
+        for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+            ROB_WRITER &writer = last_writer[ROB.entry[ROB.head].destination_registers[i]];
+            if ((writer.rob_index == ROB.head) && (writer.instr_id == ROB.entry[ROB.head].instr_id))
+                writer = ROB_WRITER();
+
+            if (ROB.entry[ROB.head].destination_memory[i])
+                store_index.erase(ROB.entry[ROB.head].destination_memory[i], ROB.head, ROB.entry[ROB.head].instr_id);
+        }
+
         ooo_model_instr empty_entry;
         ROB.entry[ROB.head] = empty_entry;
+        rob_event.update(ROB.head, 0);
+        memory_event.update(ROB.head, 0);
+        completing.erase(ROB.head);
+        memory_ready.erase(ROB.head);
 
         ROB.head++;
         if (ROB.head == ROB.SIZE)
@@ -1956,3 +2034,216 @@ void O3_CPU::retire_rob()
         num_retired++;
     }
 }
+
+// earliest cycle at which this core could change state if nothing else happens in the system
+// a return value of (current cycle + 1) or less means the core has work to do in the next cycle
+// every check below mirrors the gating conditions of the corresponding pipeline stage
+uint64_t O3_CPU::get_next_event_cycle()
+{
+    uint64_t next_cycle = current_core_cycle[cpu] + 1,
+             next_event = UINT64_MAX;
+
+    // deadlock check is done regardless of the stall
+    if (ROB.entry[ROB.head].ip)
+        next_event = ROB.entry[ROB.head].event_cycle + DEADLOCK_CYCLE;
+
+    // core is stalled due to page fault
+    if (stall_cycle[cpu] > next_cycle)
+        return (stall_cycle[cpu] < next_event) ? stall_cycle[cpu] : next_event;
+
+    // fetch unit
+    if ((ROB.occupancy < ROB.SIZE) && (fetch_stall == 0))
+        return next_cycle;
+    if (fetch_stall && fetch_resume_cycle && (fetch_resume_cycle < next_event))
+        next_event = fetch_resume_cycle;
+
+    // retire
+    if (ROB.entry[ROB.head].executed == COMPLETED) {
+        if (ROB.entry[ROB.head].event_cycle <= next_cycle)
+            return next_cycle;
+        if (ROB.entry[ROB.head].event_cycle < next_event)
+            next_event = ROB.entry[ROB.head].event_cycle;
+    }
+
+    // ITLB and L1I fetch
+    uint32_t read_index = (ROB.last_read == (ROB.SIZE-1)) ? 0 : (ROB.last_read + 1);
+    if (ROB.entry[read_index].ip && (ROB.entry[read_index].translated == 0))
+        return next_cycle;
+
+    uint32_t fetch_index = (ROB.last_fetch == (ROB.SIZE-1)) ? 0 : (ROB.last_fetch + 1);
+    if (ROB.entry[fetch_index].translated == COMPLETED) {
+        if ((ROB.entry[fetch_index].event_cycle <= next_cycle) && (ROB.entry[fetch_index].fetched == 0))
+            return next_cycle;
+        if ((ROB.entry[fetch_index].event_cycle > next_cycle) && (ROB.entry[fetch_index].event_cycle < next_event))
+            next_event = ROB.entry[fetch_index].event_cycle;
+    }
+
+    // ready-to-execute, ready-to-load and ready-to-store heads
+    if (RTE0[RTE0_head] < ROB.SIZE) {
+        if (ROB.entry[RTE0[RTE0_head]].event_cycle <= next_cycle)
+            return next_cycle;
+        if (ROB.entry[RTE0[RTE0_head]].event_cycle < next_event)
+            next_event = ROB.entry[RTE0[RTE0_head]].event_cycle;
+    }
+    if (RTE1[RTE1_head] < ROB.SIZE) {
+        if (ROB.entry[RTE1[RTE1_head]].event_cycle <= next_cycle)
+            return next_cycle;
+        if (ROB.entry[RTE1[RTE1_head]].event_cycle < next_event)
+            next_event = ROB.entry[RTE1[RTE1_head]].event_cycle;
+    }
+
+    uint32_t sq_ready[2] = {RTS0[RTS0_head], RTS1[RTS1_head]},
+             lq_ready[2] = {RTL0[RTL0_head], RTL1[RTL1_head]};
+    for (uint32_t i=0; i<2; i++) {
+        if (sq_ready[i] < SQ.SIZE) {
+            if (SQ.entry[sq_ready[i]].event_cycle <= next_cycle)
+                return next_cycle;
+            if (SQ.entry[sq_ready[i]].event_cycle < next_event)
+                next_event = SQ.entry[sq_ready[i]].event_cycle;
+        }
+        if (lq_ready[i] < LQ.SIZE) {
+            if (LQ.entry[lq_ready[i]].event_cycle <= next_cycle)
+                return next_cycle;
+            if (LQ.entry[lq_ready[i]].event_cycle < next_event)
+                next_event = LQ.entry[lq_ready[i]].event_cycle;
+        }
+    }
+
+    // completed fetches waiting in the processed queues
+    PACKET_QUEUE *processed[4] = {&ITLB.PROCESSED, &L1I.PROCESSED, &DTLB.PROCESSED, &L1D.PROCESSED};
+    for (uint32_t i=0; i<4; i++) {
+        if (processed[i]->occupancy) {
+            if (processed[i]->entry[processed[i]->head].event_cycle <= next_cycle)
+                return next_cycle;
+            if (processed[i]->entry[processed[i]->head].event_cycle < next_event)
+                next_event = processed[i]->entry[processed[i]->head].event_cycle;
+        }
+    }
+
+    // private caches and TLBs
+    CACHE *cache[6] = {&ITLB, &DTLB, &STLB, &L1I, &L1D, &L2C};
+    for (uint32_t i=0; i<6; i++) {
+        uint64_t cache_event = cache[i]->get_next_event_cycle();
+        if (cache_event <= next_cycle)
+            return next_cycle;
+        if (cache_event < next_event)
+            next_event = cache_event;
+    }
+
+    // in-flight executions
+    if ((inflight_reg_executions > 0) || (inflight_mem_executions > 0)) {
+        for (uint32_t n=find_in_window(completing, 0, ROB.occupancy); n<ROB.occupancy; n=find_in_window(completing, n+1, ROB.occupancy)) {
+            uint32_t i = (ROB.head + n) % ROB.SIZE;
+            if (ROB.entry[i].event_cycle <= next_cycle)
+                return next_cycle;
+            if (ROB.entry[i].event_cycle < next_event)
+                next_event = ROB.entry[i].event_cycle;
+        }
+    }
+
+    // in-order scheduling windows
+    uint64_t schedule_event = get_next_schedule_event(next_cycle);
+    if (schedule_event <= next_cycle)
+        return next_cycle;
+    if (schedule_event < next_event)
+        next_event = schedule_event;
+
+    schedule_event = get_next_memory_schedule_event(next_cycle);
+    if (schedule_event <= next_cycle)
+        return next_cycle;
+    if (schedule_event < next_event)
+        next_event = schedule_event;
+
+    return next_event;
+}
+
+// looks up the ROB exactly like schedule_instruction() would in the given cycle without changing anything
+uint64_t O3_CPU::get_next_schedule_event(uint64_t cycle)
+{
+    uint32_t schedule_index = ROB.next_schedule;
+    if (ROB.entry[schedule_index].scheduled)
+        return UINT64_MAX;
+    if (ROB.entry[schedule_index].event_cycle > cycle)
+        return ROB.entry[schedule_index].event_cycle;
+
+    if ((ROB.head == ROB.tail) && ROB.occupancy == 0)
+        return UINT64_MAX;
+
+    uint32_t limit = ROB.next_fetch[1],
+             window = (ROB.head < limit) ? (limit - ROB.head) : (ROB.SIZE - ROB.head + limit),
+             scheduled = scheduled_window();
+    if (scheduled > window)
+        scheduled = window;
+    if (scheduled > SCHEDULER_SIZE)
+        scheduled = SCHEDULER_SIZE;
+
+    uint32_t late = find_later_in_window(rob_event, 0, scheduled, cycle);
+    if (late < scheduled)
+        return ROB.entry[(ROB.head + late) % ROB.SIZE].event_cycle;
+
+    // the first unscheduled entry
+    if ((scheduled == window) || (scheduled >= SCHEDULER_SIZE))
+        return UINT64_MAX;
+
+    uint32_t i = (ROB.head + scheduled) % ROB.SIZE;
+    if (ROB.entry[i].fetched != COMPLETED)
+        return UINT64_MAX;
+    if (ROB.entry[i].event_cycle > cycle)
+        return ROB.entry[i].event_cycle;
+
+    return cycle;
+}
+
+// looks up the ROB exactly like schedule_memory_instruction() would in the given cycle without changing anything
+uint64_t O3_CPU::get_next_memory_schedule_event(uint64_t cycle)
+{
+    if ((ROB.head == ROB.tail) && ROB.occupancy == 0)
+        return UINT64_MAX;
+
+    uint32_t window = scheduled_window(), searched = 0, n = 0;
+    while (n < window) {
+        if (searched >= SCHEDULER_SIZE)
+            return UINT64_MAX;
+
+        uint32_t ready = find_in_window(memory_ready, n, window),
+                 end = (ready < window) ? (ready + 1) : window,
+                 late = find_later_in_window(memory_event, n, end, cycle);
+        if (late < end)
+            return ROB.entry[(ROB.head + late) % ROB.SIZE].event_cycle;
+        if (ready == window)
+            break;
+
+        n = ready + 1;
+
+        uint32_t i = (ROB.head + ready) % ROB.SIZE;
+        if ((ROB.entry[i].reg_ready == 0) || (ROB.entry[i].scheduled != INFLIGHT))
+            continue;
+
+        // check_and_add_lsq() would make progress if any memory operation can be added
+        uint32_t num_mem_ops = 0, num_added = 0;
+        for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
+            if (ROB.entry[i].source_memory[j]) {
+                num_mem_ops++;
+                if (ROB.entry[i].source_added[j])
+                    num_added++;
+                else if (LQ.occupancy < LQ.SIZE)
+                    return cycle;
+            }
+        }
+        for (uint32_t j=0; j<MAX_INSTR_DESTINATIONS; j++) {
+            if (ROB.entry[i].destination_memory[j]) {
+                num_mem_ops++;
+                if (ROB.entry[i].destination_added[j])
+                    num_added++;
+                else if ((SQ.occupancy < SQ.SIZE) && (STA[STA_head] == ROB.entry[i].instr_id))
+                    return cycle;
+            }
+        }
+        if (num_added == num_mem_ops)
+            return cycle;
+
+        searched++;
+    }
+
+    return UINT64_MAX;
+}
@@ -0,0 +1,71 @@
+#include "parallel.h"
+
+void SPIN_BARRIER::wait()
+{
+    uint32_t my_generation = generation.load(std::memory_order_acquire);
+
+    // the last thread to arrive releases everybody else
+    if (count.fetch_add(1, std::memory_order_acq_rel) == (num_threads - 1)) {
+        count.store(0, std::memory_order_relaxed);
+        generation.store(my_generation + 1, std::memory_order_release);
+        return;
+    }
+
+    uint32_t spins = 0;
+    while (generation.load(std::memory_order_acquire) == my_generation) {
+        if (++spins == BARRIER_SPIN_LIMIT) {
+            std::this_thread::yield();
+            spins = 0;
+        }
+    }
+}
+
+void PARALLEL_ENGINE::start(uint32_t threads, void (*work)(uint32_t cpu, uint32_t phase))
+{
+    num_threads = threads;
+    core_work = work;
+    barrier.num_threads = threads;
+
+    for (uint32_t i=1; i<num_threads; i++)
+        workers.push_back(std::thread(&PARALLEL_ENGINE::worker_loop, this, i));
+}
+
+void PARALLEL_ENGINE::run(uint32_t run_phase)
+{
+    phase = run_phase;
+
+    barrier.wait();
+    run_cores(0);
+    barrier.wait();
+}
+
+void PARALLEL_ENGINE::stop()
+{
+    if (workers.empty())
+        return;
+
+    phase = PARALLEL_EXIT;
+    barrier.wait();
+
+    for (uint32_t i=0; i<workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+}
+
+void PARALLEL_ENGINE::worker_loop(uint32_t thread_id)
+{
+    while (1) {
+        barrier.wait();
+        if (phase == PARALLEL_EXIT)
+            return;
+
+        run_cores(thread_id);
+        barrier.wait();
+    }
+}
+
+void PARALLEL_ENGINE::run_cores(uint32_t thread_id)
+{
+    for (uint32_t i=thread_id; i<NUM_CPUS; i+=num_threads)
+        core_work(i, phase);
+}
@@ -0,0 +1,98 @@
+#include "shadow_llc.h"
+
+vector<SHADOW_LLC *> shadow_llcs;
+
+map<string, SHADOW_LLC_FACTORY> &shadow_llc_policies()
+{
+    // function-local so that policies can register from their static initializers
+    static map<string, SHADOW_LLC_FACTORY> policies;
+
+    return policies;
+}
+
+void add_shadow_llcs(const char *names)
+{
+    istringstream list(names);
+    string name;
+
+    while (getline(list, name, ',')) {
+        map<string, SHADOW_LLC_FACTORY>::iterator policy = shadow_llc_policies().find(name);
+        if (policy == shadow_llc_policies().end()) {
+            cerr << "[LLC_SHADOW] unknown replacement policy: " << name << " available:";
+            for (policy = shadow_llc_policies().begin(); policy != shadow_llc_policies().end(); policy++)
+                cerr << " " << policy->first;
+            cerr << endl;
+            assert(0);
+        }
+
+        SHADOW_LLC *shadow = policy->second();
+        shadow->initialize_replacement();
+        shadow_llcs.push_back(shadow);
+    }
+}
+
+void shadow_llc_access(PACKET *packet)
+{
+    for (uint32_t i=0; i<shadow_llcs.size(); i++)
+        shadow_llcs[i]->access(packet);
+}
+
+void SHADOW_LLC::access(PACKET *packet)
+{
+    uint32_t set = (uint32_t) (packet->address & ((1 << lg2(NUM_SET)) - 1));
+
+    uint32_t way = NUM_WAY;
+    for (uint32_t i=0; i<NUM_WAY; i++) {
+        if (block[set][i].valid && (block[set][i].tag == packet->address)) {
+            way = i;
+            break;
+        }
+    }
+
+    sim_access[packet->cpu][packet->type]++;
+
+    if (way < NUM_WAY) { // hit
+        update_replacement(packet->cpu, set, way, block[set][way].full_addr, packet->ip, 0, packet->type, 1);
+        sim_hit[packet->cpu][packet->type]++;
+        return;
+    }
+
+    sim_miss[packet->cpu][packet->type]++;
+
+    way = find_victim_way(packet->cpu, packet->instr_id, set, packet->ip, packet->full_addr, packet->type);
+    if (way == NUM_WAY) { // bypass
+        update_replacement(packet->cpu, set, way, packet->full_addr, packet->ip, 0, packet->type, 0);
+        return;
+    }
+
+    update_replacement(packet->cpu, set, way, packet->full_addr, packet->ip, block[set][way].full_addr, packet->type, 0);
+
+    block[set][way].valid = 1;
+    block[set][way].dirty = 0;
+    block[set][way].prefetch = (packet->type == PREFETCH) ? 1 : 0;
+    block[set][way].used = 0;
+    block[set][way].tag = packet->address;
+    block[set][way].address = packet->address;
+    block[set][way].full_addr = packet->full_addr;
+    block[set][way].data = packet->data;
+    block[set][way].cpu = packet->cpu;
+    block[set][way].instr_id = packet->instr_id;
+}
+
+void SHADOW_LLC::reset_stats(uint32_t cpu)
+{
+    for (uint32_t i=0; i<NUM_TYPES; i++) {
+        sim_access[cpu][i] = 0;
+        sim_hit[cpu][i] = 0;
+        sim_miss[cpu][i] = 0;
+    }
+}
+
+void SHADOW_LLC::record_roi_stats(uint32_t cpu)
+{
+    for (uint32_t i=0; i<NUM_TYPES; i++) {
+        roi_access[cpu][i] = sim_access[cpu][i];
+        roi_hit[cpu][i] = sim_hit[cpu][i];
+        roi_miss[cpu][i] = sim_miss[cpu][i];
+    }
+}
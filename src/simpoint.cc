@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <fstream>
+
+#include "simpoint.h"
+
+void SIMPOINT_CACHE_STATS::add(uint32_t cpu, CACHE *cache, double weight)
+{
+    for (uint32_t i=0; i<NUM_TYPES; i++) {
+        access[i] += weight * cache->roi_access[cpu][i];
+        hit[i] += weight * cache->roi_hit[cpu][i];
+        miss[i] += weight * cache->roi_miss[cpu][i];
+    }
+    miss_latency += weight * cache->total_miss_latency;
+}
+
+void SIMPOINT_CACHE_STATS::apply(uint32_t cpu, CACHE *cache)
+{
+    for (uint32_t i=0; i<NUM_TYPES; i++) {
+        cache->roi_access[cpu][i] = (uint64_t) (access[i] + 0.5);
+        cache->roi_hit[cpu][i] = (uint64_t) (hit[i] + 0.5);
+        cache->roi_miss[cpu][i] = (uint64_t) (miss[i] + 0.5);
+    }
+    cache->total_miss_latency = (uint64_t) (miss_latency + 0.5);
+}
+
+static bool simpoint_order(const SIMPOINT &a, const SIMPOINT &b)
+{
+    return a.start < b.start;
+}
+
+vector<SIMPOINT> read_simpoints(const char *filename)
+{
+    ifstream file(filename);
+    if (!file.is_open()) {
+        cerr << "[SIMPOINT] cannot open " << filename << endl;
+        assert(0);
+    }
+
+    vector<SIMPOINT> simpoints;
+    double total_weight = 0;
+
+    string line;
+    while (getline(file, line)) {
+        // skip comments and empty lines
+        size_t comment = line.find('#');
+        if (comment != string::npos)
+            line.erase(comment);
+
+        istringstream fields(line);
+        SIMPOINT simpoint;
+        if (!(fields >> simpoint.start))
+            continue;
+
+        if (!(fields >> simpoint.length >> simpoint.weight) || (simpoint.length == 0) || (simpoint.weight <= 0)) {
+            cerr << "[SIMPOINT] " << filename << ": bad region \"" << line << "\", expected \"start length weight\"" << endl;
+            assert(0);
+        }
+
+        simpoints.push_back(simpoint);
+        total_weight += simpoint.weight;
+    }
+
+    if (simpoints.empty()) {
+        cerr << "[SIMPOINT] " << filename << ": no region" << endl;
+        assert(0);
+    }
+
+    sort(simpoints.begin(), simpoints.end(), simpoint_order);
+
+    for (uint32_t i=0; i<simpoints.size(); i++) {
+        simpoints[i].weight /= total_weight;
+
+        if ((i > 0) && (simpoints[i].start < (simpoints[i-1].start + simpoints[i-1].length))) {
+            cerr << "[SIMPOINT] " << filename << ": regions starting at " << simpoints[i-1].start << " and " << simpoints[i].start << " overlap" << endl;
+            assert(0);
+        }
+    }
+
+    return simpoints;
+}
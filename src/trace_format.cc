@@ -0,0 +1,247 @@
+#include <string.h>
+#include <vector>
+
+#include "trace_format.h"
+#include "instruction.h"
+
+// a delta encoded block keeps every kind of field in a stream of its own:
+//   uint32_t size of the register stream, uint32_t size of the IP stream
+//   control:   per record the branch flags, a mask of its non-zero registers, a mask of its non-zero addresses (and the asid)
+//   registers: the non-zero register numbers
+//   ip:        zigzag varint deltas from the previous IP
+//   memory:    zigzag varint deltas from the previous non-zero address
+// alike bytes end up next to each other, which xz compresses much better than whole records,
+// and the decoder walks every stream front to back without looking for record boundaries.
+// deltas start from 0 in every block so that blocks still decode on their own
+#define DELTA_BLOCK_HEADER 8
+
+#define DELTA_BRANCH       1
+#define DELTA_BRANCH_TAKEN 2
+
+static uint32_t control_bytes(const input_instr *)
+{
+    return 3;
+}
+
+static uint32_t control_bytes(const cloudsuite_instr *)
+{
+    return 5;
+}
+
+static void put_asid(const input_instr &, uint8_t *&)
+{
+}
+
+static void put_asid(const cloudsuite_instr &record, uint8_t *&out)
+{
+    *out++ = record.asid[0];
+    *out++ = record.asid[1];
+}
+
+static void get_asid(input_instr &, const uint8_t *&)
+{
+}
+
+static void get_asid(cloudsuite_instr &record, const uint8_t *&in)
+{
+    record.asid[0] = *in++;
+    record.asid[1] = *in++;
+}
+
+static inline void put_varint(std::vector<uint8_t> &out, uint64_t delta)
+{
+    // zigzag, small negative deltas stay short too
+    uint64_t value = (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+    while (value >= 0x80) {
+        out.push_back((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+static inline int get_varint(const uint8_t *&in, const uint8_t *end, uint64_t &delta)
+{
+    // most deltas fit in a byte
+    if ((in < end) && (*in < 0x80)) {
+        uint64_t value = *in++;
+        delta = (value >> 1) ^ (0 - (value & 1));
+        return 1;
+    }
+
+    uint64_t value = 0;
+    for (uint32_t shift = 0; (in < end) && (shift < 64); shift += 7) {
+        uint8_t byte = *in++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            delta = (value >> 1) ^ (0 - (value & 1));
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+template <class T>
+static uint64_t encode_records(const T *records, uint64_t num_records, uint8_t *out)
+{
+    const uint32_t num_destinations = sizeof(records->destination_registers),
+                   num_sources = sizeof(records->source_registers);
+    static_assert(sizeof(records->destination_registers) + sizeof(records->source_registers) <= 8, "register mask does not fit in a byte");
+
+    uint8_t *control = out + DELTA_BLOCK_HEADER;
+    std::vector<uint8_t> registers, ip_stream, memory;
+    uint64_t ip = 0, address = 0;
+
+    for (uint64_t i=0; i<num_records; i++) {
+        const T &record = records[i];
+
+        // the tracer writes these as bools
+        if ((record.is_branch > 1) || (record.branch_taken > 1))
+            return 0;
+        *control++ = (record.is_branch ? DELTA_BRANCH : 0) | (record.branch_taken ? DELTA_BRANCH_TAKEN : 0);
+
+        uint8_t register_mask = 0, memory_mask = 0;
+        for (uint32_t j=0; j<num_destinations; j++) {
+            if (record.destination_registers[j]) {
+                register_mask |= 1 << j;
+                registers.push_back(record.destination_registers[j]);
+            }
+            if (record.destination_memory[j]) {
+                memory_mask |= 1 << j;
+                put_varint(memory, record.destination_memory[j] - address);
+                address = record.destination_memory[j];
+            }
+        }
+        for (uint32_t j=0; j<num_sources; j++) {
+            if (record.source_registers[j]) {
+                register_mask |= 1 << (num_destinations + j);
+                registers.push_back(record.source_registers[j]);
+            }
+            if (record.source_memory[j]) {
+                memory_mask |= 1 << (num_destinations + j);
+                put_varint(memory, record.source_memory[j] - address);
+                address = record.source_memory[j];
+            }
+        }
+        *control++ = register_mask;
+        *control++ = memory_mask;
+        put_asid(record, control);
+
+        put_varint(ip_stream, record.ip - ip);
+        ip = record.ip;
+    }
+
+    uint32_t register_size = registers.size(),
+             ip_size = ip_stream.size();
+    memcpy(out, &register_size, sizeof(register_size));
+    memcpy(out + sizeof(register_size), &ip_size, sizeof(ip_size));
+
+    uint8_t *end = control;
+    memcpy(end, registers.data(), registers.size());
+    end += registers.size();
+    memcpy(end, ip_stream.data(), ip_stream.size());
+    end += ip_stream.size();
+    memcpy(end, memory.data(), memory.size());
+    end += memory.size();
+
+    return end - out;
+}
+
+template <class T>
+static int decode_records(const uint8_t *in, uint64_t size, uint64_t num_records, T *records)
+{
+    const uint32_t num_destinations = sizeof(records->destination_registers),
+                   num_sources = sizeof(records->source_registers);
+
+    uint64_t control_size = num_records * control_bytes(records);
+    if (size < DELTA_BLOCK_HEADER + control_size)
+        return 0;
+
+    uint32_t register_size, ip_size;
+    memcpy(&register_size, in, sizeof(register_size));
+    memcpy(&ip_size, in + sizeof(register_size), sizeof(ip_size));
+    if ((uint64_t)register_size + ip_size > size - DELTA_BLOCK_HEADER - control_size)
+        return 0;
+
+    const uint8_t *control = in + DELTA_BLOCK_HEADER,
+                  *registers = control + control_size,
+                  *registers_end = registers + register_size,
+                  *ip_stream = registers_end,
+                  *ip_end = ip_stream + ip_size,
+                  *memory = ip_end,
+                  *memory_end = in + size;
+
+    // only the non-zero fields are stored, clear the rest (and any padding) in one go
+    memset((void *)records, 0, num_records * sizeof(T));
+
+    uint64_t ip = 0, address = 0, delta;
+    for (uint64_t i=0; i<num_records; i++) {
+        T &record = records[i];
+
+        uint8_t flags = control[0],
+                register_mask = control[1],
+                memory_mask = control[2];
+        control += 3;
+        get_asid(record, control);
+
+        record.is_branch = (flags & DELTA_BRANCH) ? 1 : 0;
+        record.branch_taken = (flags & DELTA_BRANCH_TAKEN) ? 1 : 0;
+
+        if (!get_varint(ip_stream, ip_end, delta))
+            return 0;
+        ip += delta;
+        record.ip = ip;
+
+        if (register_mask) {
+            if (registers + __builtin_popcount(register_mask) > registers_end)
+                return 0;
+            for (uint32_t j=0; j<num_destinations; j++)
+                if (register_mask & (1 << j))
+                    record.destination_registers[j] = *registers++;
+            for (uint32_t j=0; j<num_sources; j++)
+                if (register_mask & (1 << (num_destinations + j)))
+                    record.source_registers[j] = *registers++;
+        }
+
+        if (memory_mask) {
+            for (uint32_t j=0; j<num_destinations; j++) {
+                if (memory_mask & (1 << j)) {
+                    if (!get_varint(memory, memory_end, delta))
+                        return 0;
+                    address += delta;
+                    record.destination_memory[j] = address;
+                }
+            }
+            for (uint32_t j=0; j<num_sources; j++) {
+                if (memory_mask & (1 << (num_destinations + j))) {
+                    if (!get_varint(memory, memory_end, delta))
+                        return 0;
+                    address += delta;
+                    record.source_memory[j] = address;
+                }
+            }
+        }
+    }
+
+    return (registers == registers_end) && (ip_stream == ip_end) && (memory == memory_end);
+}
+
+uint64_t delta_block_bound(uint64_t records, uint32_t record_size)
+{
+    // control bytes, registers and up to 10 bytes per varint stay well below twice the record
+    return DELTA_BLOCK_HEADER + records * 2 * record_size;
+}
+
+uint64_t encode_delta_block(const uint8_t *records, uint64_t num_records, uint32_t record_size, uint8_t *out)
+{
+    if (record_size == sizeof(cloudsuite_instr))
+        return encode_records((const cloudsuite_instr *)records, num_records, out);
+    return encode_records((const input_instr *)records, num_records, out);
+}
+
+int decode_delta_block(const uint8_t *in, uint64_t size, uint64_t num_records, uint32_t record_size, uint8_t *records)
+{
+    if (record_size == sizeof(cloudsuite_instr))
+        return decode_records(in, size, num_records, (cloudsuite_instr *)records);
+    return decode_records(in, size, num_records, (input_instr *)records);
+}
@@ -0,0 +1,595 @@
+#include <chrono>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "trace_reader.h"
+
+// cache_dir may be NULL, compressed traces are then decoded by this process alone
+void TRACE_READER::open(const char *filename, uint32_t size, const char *cache_dir)
+{
+    name = filename;
+    record_size = size;
+
+    uint8_t magic[8] = {0};
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        cerr << endl << "*** CANNOT OPEN TRACE FILE: " << name << " ***" << endl;
+        assert(0);
+    }
+    size_t magic_size = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    // anything else is taken for uncompressed records
+    if ((magic_size == sizeof(magic)) && (memcmp(magic, CTRACE_MAGIC, sizeof(magic)) == 0))
+        format = TRACE_CHUNKED;
+    else if (memcmp(magic, "\xfd" "7zXZ", 5) == 0)
+        format = TRACE_XZ;
+    else if (memcmp(magic, "\x1f\x8b", 2) == 0)
+        format = TRACE_GZ;
+    else
+        format = TRACE_PLAIN;
+
+    if (format == TRACE_PLAIN)
+        map(filename, 0, UINT64_MAX);
+    else if (cache_dir && open_cached(cache_dir))
+        format = TRACE_PLAIN;
+    else if (format == TRACE_CHUNKED)
+        open_chunked();
+
+    if (mapped) {
+        start(0);
+        return;
+    }
+
+    ring_size = (uint64_t)TRACE_RING_RECORDS * record_size;
+    ring = new uint8_t[ring_size];
+    xz_input = new uint8_t[TRACE_CHUNK_SIZE];
+
+    start(0);
+}
+
+// maps the given number of records found at offset, as many as the file holds with UINT64_MAX
+void TRACE_READER::map(const char *filename, uint64_t offset, uint64_t records)
+{
+    int fd = ::open(filename, O_RDONLY);
+    struct stat file_stat;
+    if ((fd < 0) || (fstat(fd, &file_stat) != 0)) {
+        cerr << endl << "*** CANNOT OPEN TRACE FILE: " << name << " ***" << endl;
+        assert(0);
+    }
+
+    // a trailing partial record is dropped like fread did
+    uint64_t file_records = ((uint64_t)file_stat.st_size > offset) ? (file_stat.st_size - offset) / record_size : 0;
+    if (records == UINT64_MAX)
+        records = file_records;
+    else if (records > file_records) {
+        cerr << "[TRACE_READER] " << name << ": holds " << file_records << " records, the header says " << records << endl;
+        assert(0);
+    }
+
+    num_records = records;
+    map_size = file_stat.st_size;
+    mapped = 1;
+    if (records) {
+        void *addr = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            cerr << "[TRACE_READER] " << name << ": mmap failed" << endl;
+            assert(0);
+        }
+        map_data = (uint8_t *)addr;
+        madvise(map_data, map_size, MADV_SEQUENTIAL);
+
+        map_begin = map_data + offset;
+        map_end = map_begin + records * record_size;
+    }
+    ::close(fd);
+}
+
+// maps the decoded copy of the trace in cache_dir, which is decoded only once and only as far as the runs read it.
+// the copy grows while processes map it: a writer thread publishes how many records it holds in its header page,
+// and the readers follow it (see follow_writer()). concurrent simulations of the same trace share the copy through
+// the page cache, which is memory when cache_dir is on a tmpfs like /dev/shm. the copy is named after the trace
+// and a hash of its path, size and modification time, a changed trace gets a new copy. returns 0 when the cache
+// cannot be used
+int TRACE_READER::open_cached(const char *cache_dir)
+{
+    char *path = realpath(name.c_str(), NULL);
+    struct stat trace_stat;
+    if ((path == NULL) || (stat(path, &trace_stat) != 0)) {
+        free(path);
+        return 0;
+    }
+
+    // FNV-1a
+    uint64_t key = 14695981039346656037ULL,
+             fields[3] = {(uint64_t)trace_stat.st_size, (uint64_t)trace_stat.st_mtime, record_size};
+    for (char *p = path; *p; p++)
+        key = (key ^ (uint8_t)*p) * 1099511628211ULL;
+    for (uint32_t i=0; i<3; i++)
+        key = (key ^ fields[i]) * 1099511628211ULL;
+
+    const char *base_name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    ostringstream cached_name;
+    cached_name << cache_dir << "/" << base_name << "." << hex << key << ".champsimtrace";
+    free(path);
+
+    string cached = cached_name.str(),
+           lock_name = cached + ".lock";
+
+    // only the header of a new copy is written under the lock, the records are written by the writer thread
+    int lock = ::open(lock_name.c_str(), O_RDWR | O_CREAT, 0666);
+    if ((lock < 0) || (flock(lock, LOCK_EX) != 0)) {
+        cerr << "[TRACE_READER] cannot lock " << lock_name << ", decoding " << name << " in this process" << endl;
+        if (lock >= 0)
+            ::close(lock);
+        return 0;
+    }
+
+    // a new copy, or one left by an older simulator without a header, starts empty
+    char magic[8] = {0};
+    cache_fd = ::open(cached.c_str(), O_RDWR | O_CREAT, 0666);
+    uint8_t ok = (cache_fd >= 0),
+            empty = ok && ((pread(cache_fd, magic, sizeof(magic), 0) != sizeof(magic)) || (memcmp(magic, TRACE_CACHE_MAGIC, sizeof(magic)) != 0));
+    if (empty)
+        ok = (ftruncate(cache_fd, 0) == 0) && (ftruncate(cache_fd, TRACE_CACHE_HEADER_SIZE) == 0);
+
+    void *header = MAP_FAILED;
+    if (ok) {
+        header = mmap(NULL, TRACE_CACHE_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, cache_fd, 0);
+        ok = (header != MAP_FAILED);
+    }
+    if (ok) {
+        cache_header = (TRACE_CACHE_HEADER *)header;
+        if (empty) {
+            cache_header->record_size = record_size;
+            memcpy(cache_header->magic, TRACE_CACHE_MAGIC, sizeof(magic));
+        }
+    }
+
+    flock(lock, LOCK_UN);
+    ::close(lock);
+
+    // the records are mapped past the end of the file, only the published ones are read
+    void *records = MAP_FAILED;
+    if (ok) {
+        records = mmap(NULL, TRACE_CACHE_RESERVE, PROT_READ, MAP_SHARED, cache_fd, TRACE_CACHE_HEADER_SIZE);
+        ok = (records != MAP_FAILED) && (cache_header->record_size == record_size);
+    }
+
+    if (!ok) {
+        cerr << "[TRACE_READER] cannot use " << cached << ", decoding " << name << " in this process" << endl;
+        if (records != MAP_FAILED)
+            munmap(records, TRACE_CACHE_RESERVE);
+        close_cached();
+        return 0;
+    }
+
+    map_data = (uint8_t *)records;
+    map_size = TRACE_CACHE_RESERVE;
+    mapped = 1;
+    map_begin = map_data;
+
+    // complete is read first, once it is set all the records have been published
+    uint8_t complete = cache_header->complete.load(std::memory_order_acquire);
+    uint64_t decoded = cache_header->decoded.load(std::memory_order_acquire);
+    map_end = map_begin + decoded;
+    growing = !complete;
+    num_records = complete ? decoded / record_size : 0;
+
+    return 1;
+}
+
+// the core read every record published so far in the decoded copy. asks the writer for more and waits for them,
+// and becomes the writer when no process holds the lock of the copy, e.g. when the one decoding it has exited.
+// returns 0 at the end of the trace
+int TRACE_READER::follow_writer()
+{
+    if (!growing)
+        return 0;
+
+    uint64_t position = map_position - map_begin,
+             ahead = position + (uint64_t)TRACE_CACHE_AHEAD * record_size,
+             wanted = cache_header->wanted.load(std::memory_order_relaxed);
+    while ((wanted < ahead) && !cache_header->wanted.compare_exchange_weak(wanted, ahead))
+        ;
+
+    while (1) {
+        uint8_t complete = cache_header->complete.load(std::memory_order_acquire);
+        uint64_t decoded = cache_header->decoded.load(std::memory_order_acquire);
+        map_end = map_begin + decoded;
+        if (complete) {
+            growing = 0;
+            num_records = decoded / record_size;
+        }
+
+        if (decoded > position)
+            return 1;
+        if (complete)
+            return 0;
+
+        if (!cache_writer.joinable() && (flock(cache_fd, LOCK_EX | LOCK_NB) == 0)) {
+            cout << "Decoding " << name << " into the trace cache from record " << decoded / record_size << endl;
+            cache_writer = std::thread(&TRACE_READER::cache_writer_loop, this);
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+// decodes the trace into the copy, after the records already published and as far as the readers want it
+void TRACE_READER::cache_writer_loop()
+{
+    TRACE_READER decoder;
+    decoder.open(name.c_str(), record_size, NULL);
+
+    uint64_t decoded = cache_header->decoded.load(std::memory_order_acquire);
+    if (decoder.seekable())
+        decoder.seek(decoded / record_size);
+    else {
+        for (uint64_t i=0; i<decoded/record_size; i++)
+            decoder.next();
+    }
+
+    uint64_t chunk_records = TRACE_CHUNK_SIZE / record_size;
+    vector<uint8_t> chunk(chunk_records * record_size);
+    while (!cache_stop.load(std::memory_order_relaxed)) {
+        if (decoded >= cache_header->wanted.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        uint64_t records = 0;
+        const uint8_t *record;
+        while ((records < chunk_records) && ((record = decoder.next()) != NULL))
+            memcpy(chunk.data() + (records++ * record_size), record, record_size);
+
+        uint64_t bytes = records * record_size;
+        if (bytes && (pwrite(cache_fd, chunk.data(), bytes, TRACE_CACHE_HEADER_SIZE + decoded) != (ssize_t)bytes)) {
+            cerr << "[TRACE_READER] cannot write the decoded copy of " << name << " into the trace cache" << endl;
+            assert(0);
+        }
+
+        // the records are in the page cache before the readers see them
+        decoded += bytes;
+        cache_header->decoded.store(decoded, std::memory_order_release);
+
+        if (records < chunk_records) {
+            cache_header->complete.store(1, std::memory_order_release);
+            break;
+        }
+    }
+
+    flock(cache_fd, LOCK_UN);
+}
+
+// stops the writer thread, which releases the lock of the copy for the other processes following it
+void TRACE_READER::close_cached()
+{
+    if (cache_writer.joinable()) {
+        cache_stop = 1;
+        cache_writer.join();
+    }
+
+    if (cache_header)
+        munmap(cache_header, TRACE_CACHE_HEADER_SIZE);
+    cache_header = NULL;
+
+    if (cache_fd >= 0)
+        ::close(cache_fd);
+    cache_fd = -1;
+}
+
+void TRACE_READER::unmap()
+{
+    if (map_data)
+        munmap(map_data, map_size);
+    map_data = NULL;
+    mapped = 0;
+}
+
+// reads the header and the block index of a chunked trace
+void TRACE_READER::open_chunked()
+{
+    chunked_file = fopen(name.c_str(), "rb");
+    if ((chunked_file == NULL) || (fread(&header, sizeof(header), 1, chunked_file) != 1)) {
+        cerr << "[TRACE_READER] " << name << ": cannot read the chunked trace header" << endl;
+        assert(0);
+    }
+
+    if (header.record_size != record_size) {
+        cerr << "[TRACE_READER] " << name << ": records of " << header.record_size << " bytes, this run reads " << record_size << " (-cloudsuite)" << endl;
+        assert(0);
+    }
+
+    if ((header.encoding > CTRACE_ENCODING_DELTA) || (header.compression > CTRACE_COMPRESSION_NONE)) {
+        cerr << "[TRACE_READER] " << name << ": unknown block encoding " << header.encoding << " or compression " << header.compression << endl;
+        assert(0);
+    }
+
+    index.resize(header.num_blocks);
+    if ((fseek(chunked_file, header.index_offset, SEEK_SET) != 0)
+        || (fread(index.data(), sizeof(CTRACE_BLOCK), header.num_blocks, chunked_file) != header.num_blocks)) {
+        cerr << "[TRACE_READER] " << name << ": cannot read the block index" << endl;
+        assert(0);
+    }
+
+    num_records = header.num_records;
+
+    // raw uncompressed blocks follow each other, the records are used in place
+    if ((header.encoding == CTRACE_ENCODING_RAW) && (header.compression == CTRACE_COMPRESSION_NONE)) {
+        uint8_t contiguous = 1;
+        for (uint64_t i=0; i<header.num_blocks; i++)
+            if (index[i].offset != sizeof(header) + i * header.records_per_block * record_size)
+                contiguous = 0;
+
+        if (contiguous) {
+            fclose(chunked_file);
+            chunked_file = NULL;
+            map(name.c_str(), sizeof(header), header.num_records);
+            return;
+        }
+    }
+
+    block_data = new uint8_t[(uint64_t)header.records_per_block * record_size];
+    if ((header.encoding == CTRACE_ENCODING_DELTA) && (header.compression == CTRACE_COMPRESSION_XZ))
+        encoded_data = new uint8_t[delta_block_bound(header.records_per_block, record_size)];
+}
+
+// starts decoding at the given record, which can only be non-zero for chunked traces
+void TRACE_READER::start(uint64_t record)
+{
+    if (mapped) {
+        if (!growing && (record > num_records))
+            record = num_records;
+        map_position = map_begin + record * record_size;
+        return;
+    }
+
+    open_decoder(record);
+
+    first_record = record;
+    written = 0;
+    consumed = 0;
+    finished = 0;
+    stop = 0;
+    available = 0;
+    position = 0;
+
+    reader = std::thread(&TRACE_READER::reader_loop, this);
+}
+
+void TRACE_READER::close()
+{
+    if (reader.joinable()) {
+        stop = 1;
+        reader.join();
+    }
+    close_decoder();
+}
+
+void TRACE_READER::rewind()
+{
+    close();
+    start(0);
+}
+
+// a record past the end starts the pass at the end of the trace
+void TRACE_READER::seek(uint64_t record)
+{
+    assert(seekable());
+
+    close();
+    start(record);
+}
+
+// the core ran out of decoded records, wait until the reader thread publishes more or reaches the end
+int TRACE_READER::wait_for_data()
+{
+    while (1) {
+        // finished is read first, once it is set all the data has been published
+        uint8_t done = finished.load(std::memory_order_acquire);
+        available = written.load(std::memory_order_acquire);
+        if (available - position >= record_size)
+            return 1;
+
+        // a trailing partial record is dropped like fread did
+        if (done)
+            return 0;
+
+        std::this_thread::yield();
+    }
+}
+
+void TRACE_READER::reader_loop()
+{
+    uint64_t produced = 0;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        uint64_t free = ring_size - (produced - consumed.load(std::memory_order_acquire));
+
+        // the core consumes much slower than the decoder produces, refill in large steps
+        if (free < (ring_size / TRACE_REFILL_FRACTION)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        uint64_t offset = produced % ring_size,
+                 size = ring_size - offset;
+        if (size > free)
+            size = free;
+        if (size > TRACE_CHUNK_SIZE)
+            size = TRACE_CHUNK_SIZE;
+
+        uint64_t bytes = decode(ring + offset, size);
+        if (bytes == 0)
+            break;
+
+        produced += bytes;
+        written.store(produced, std::memory_order_release);
+    }
+
+    finished.store(1, std::memory_order_release);
+}
+
+void TRACE_READER::open_decoder(uint64_t record)
+{
+    if (format == TRACE_CHUNKED) {
+        // the reader thread continues right after the record in the block decoded here
+        next_block = record / header.records_per_block;
+        block_bytes = 0;
+        block_position = 0;
+        if (next_block < header.num_blocks) {
+            read_block(next_block++);
+            block_position = (record % header.records_per_block) * record_size;
+        }
+    }
+    else if (format == TRACE_XZ) {
+        xz_file = fopen(name.c_str(), "rb");
+        if (xz_file == NULL) {
+            cerr << endl << "*** CANNOT OPEN TRACE FILE: " << name << " ***" << endl;
+            assert(0);
+        }
+
+        xz_stream = LZMA_STREAM_INIT;
+        if (lzma_stream_decoder(&xz_stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+            cerr << "[TRACE_READER] cannot initialize the xz decoder for " << name << endl;
+            assert(0);
+        }
+        xz_finished = 0;
+    }
+    else {
+        gz_file = gzopen(name.c_str(), "rb");
+        if (gz_file == NULL) {
+            cerr << endl << "*** CANNOT OPEN TRACE FILE: " << name << " ***" << endl;
+            assert(0);
+        }
+        gzbuffer(gz_file, TRACE_CHUNK_SIZE);
+    }
+}
+
+void TRACE_READER::close_decoder()
+{
+    if (xz_file) {
+        lzma_end(&xz_stream);
+        fclose(xz_file);
+        xz_file = NULL;
+    }
+    if (gz_file) {
+        gzclose(gz_file);
+        gz_file = NULL;
+    }
+}
+
+// decodes up to size bytes, returns 0 at the end of the trace.
+// like "xz -dc" and "gunzip -c", a corrupt or truncated file ends the trace after a message
+uint64_t TRACE_READER::decode(uint8_t *out, uint64_t size)
+{
+    if (format == TRACE_CHUNKED)
+        return decode_chunked(out, size);
+
+    if (format == TRACE_GZ) {
+        int bytes = gzread(gz_file, out, size);
+        if (bytes < 0) {
+            int error;
+            cerr << "[TRACE_READER] " << name << ": " << gzerror(gz_file, &error) << endl;
+            return 0;
+        }
+        return bytes;
+    }
+
+    if (xz_finished)
+        return 0;
+
+    xz_stream.next_out = out;
+    xz_stream.avail_out = size;
+    while (xz_stream.avail_out == size) {
+        if ((xz_stream.avail_in == 0) && !feof(xz_file)) {
+            xz_stream.next_in = xz_input;
+            xz_stream.avail_in = fread(xz_input, 1, TRACE_CHUNK_SIZE, xz_file);
+        }
+
+        lzma_ret ret = lzma_code(&xz_stream, feof(xz_file) ? LZMA_FINISH : LZMA_RUN);
+        if (ret == LZMA_STREAM_END) {
+            xz_finished = 1;
+            break;
+        }
+        if (ret != LZMA_OK) {
+            cerr << "[TRACE_READER] " << name << ": xz decoding error " << ret << endl;
+            xz_finished = 1;
+            break;
+        }
+    }
+
+    return size - xz_stream.avail_out;
+}
+
+void TRACE_READER::read_block(uint64_t block)
+{
+    vector<uint8_t> stored(index[block].size);
+    if ((fseek(chunked_file, index[block].offset, SEEK_SET) != 0)
+        || (fread(stored.data(), 1, stored.size(), chunked_file) != stored.size())) {
+        cerr << "[TRACE_READER] " << name << ": cannot read block " << block << endl;
+        assert(0);
+    }
+
+    uint64_t records = header.num_records - block * header.records_per_block;
+    if (records > header.records_per_block)
+        records = header.records_per_block;
+
+    // raw xz blocks decompress straight into the records, delta blocks into encoded_data first
+    uint8_t *encoded = (header.encoding == CTRACE_ENCODING_RAW) ? block_data : encoded_data;
+    size_t encoded_size = stored.size();
+    if (header.compression == CTRACE_COMPRESSION_XZ) {
+        uint64_t memlimit = UINT64_MAX;
+        size_t in_position = 0, out_position = 0,
+               bound = (header.encoding == CTRACE_ENCODING_RAW) ? records * record_size : delta_block_bound(records, record_size);
+        lzma_ret ret = lzma_stream_buffer_decode(&memlimit, 0, NULL, stored.data(), &in_position, stored.size(),
+                                                 encoded, &out_position, bound);
+        if (ret != LZMA_OK) {
+            cerr << "[TRACE_READER] " << name << ": xz decoding error " << ret << " in block " << block << endl;
+            assert(0);
+        }
+        encoded_size = out_position;
+    }
+    else
+        encoded = stored.data();
+
+    if (header.encoding == CTRACE_ENCODING_DELTA) {
+        if (!decode_delta_block(encoded, encoded_size, records, record_size, block_data)) {
+            cerr << "[TRACE_READER] " << name << ": corrupt delta encoding in block " << block << endl;
+            assert(0);
+        }
+    }
+    else if (encoded != block_data) {
+        if (encoded_size != records * record_size) {
+            cerr << "[TRACE_READER] " << name << ": block " << block << " holds " << encoded_size << " bytes, expected " << records * record_size << endl;
+            assert(0);
+        }
+        memcpy(block_data, encoded, encoded_size);
+    }
+    else
+        records = encoded_size / record_size;
+
+    block_bytes = records * record_size;
+    block_position = 0;
+}
+
+uint64_t TRACE_READER::decode_chunked(uint8_t *out, uint64_t size)
+{
+    if (block_position == block_bytes) {
+        if (next_block == header.num_blocks)
+            return 0;
+        read_block(next_block++);
+    }
+
+    uint64_t bytes = block_bytes - block_position;
+    if (bytes > size)
+        bytes = size;
+    memcpy(out, block_data + block_position, bytes);
+    block_position += bytes;
+
+    return bytes;
+}
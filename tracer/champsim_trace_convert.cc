@@ -0,0 +1,164 @@
+// transcodes a gzip or xz ChampSim trace into the chunked format of inc/trace_format.h
+// usage: champsim_trace_convert [-cloudsuite] [-records_per_block N] [-encoding raw|delta] [-compression xz|none] [-preset N] input.champsimtrace.xz output.champsimtrace.ctrace
+// keep the name of the trace before the extensions, the simulator seeds itself from it
+
+#include <getopt.h>
+
+#include "trace_reader.h"
+#include "instruction.h"
+
+void write_raw(FILE *file, const void *addr, uint64_t size)
+{
+    if (fwrite(addr, 1, size, file) != size) {
+        cerr << "[TRACE_CONVERT] write error" << endl;
+        assert(0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t record_size = sizeof(input_instr),
+             records_per_block = CTRACE_RECORDS_PER_BLOCK,
+             encoding = CTRACE_ENCODING_DELTA,
+             compression = CTRACE_COMPRESSION_XZ,
+             preset = 6;
+
+    while (1) {
+        static struct option long_options[] =
+        {
+            {"cloudsuite", no_argument, 0, 'c'},
+            {"records_per_block", required_argument, 0, 'r'},
+            {"encoding", required_argument, 0, 'e'},
+            {"compression", required_argument, 0, 'z'},
+            {"preset", required_argument, 0, 'p'},
+            {0, 0, 0, 0}
+        };
+
+        int option_index = 0;
+        int c = getopt_long_only(argc, argv, "", long_options, &option_index);
+        if (c == -1)
+            break;
+
+        switch(c) {
+            case 'c':
+                record_size = sizeof(cloudsuite_instr);
+                break;
+            case 'r':
+                records_per_block = atol(optarg);
+                break;
+            case 'e':
+                if (strcmp(optarg, "raw") == 0)
+                    encoding = CTRACE_ENCODING_RAW;
+                else if (strcmp(optarg, "delta") == 0)
+                    encoding = CTRACE_ENCODING_DELTA;
+                else {
+                    cerr << "[TRACE_CONVERT] unknown encoding " << optarg << ", raw or delta" << endl;
+                    return 1;
+                }
+                break;
+            case 'z':
+                if (strcmp(optarg, "xz") == 0)
+                    compression = CTRACE_COMPRESSION_XZ;
+                else if (strcmp(optarg, "none") == 0)
+                    compression = CTRACE_COMPRESSION_NONE;
+                else {
+                    cerr << "[TRACE_CONVERT] unknown compression " << optarg << ", xz or none" << endl;
+                    return 1;
+                }
+                break;
+            case 'p':
+                preset = atol(optarg);
+                break;
+            default:
+                abort();
+        }
+    }
+
+    if ((argc - optind != 2) || (records_per_block == 0)) {
+        cerr << "usage: " << argv[0] << " [-cloudsuite] [-records_per_block N] [-encoding raw|delta] [-compression xz|none] [-preset N] input output.ctrace" << endl;
+        return 1;
+    }
+
+    TRACE_READER input;
+    input.open(argv[optind], record_size, NULL);
+
+    FILE *output = fopen(argv[optind+1], "wb");
+    if (output == NULL) {
+        cerr << "[TRACE_CONVERT] cannot open " << argv[optind+1] << endl;
+        return 1;
+    }
+
+    CTRACE_HEADER header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CTRACE_MAGIC, sizeof(header.magic));
+    header.record_size = record_size;
+    header.records_per_block = records_per_block;
+    header.encoding = encoding;
+    header.compression = compression;
+    header.num_records = 0;
+    header.num_blocks = 0;
+    header.index_offset = 0;
+
+    // the header is written again once the totals are known
+    write_raw(output, &header, sizeof(header));
+
+    uint64_t block_size = (uint64_t)records_per_block * record_size;
+    uint64_t encoded_bound = (encoding == CTRACE_ENCODING_DELTA) ? delta_block_bound(records_per_block, record_size) : block_size;
+    vector<uint8_t> block(block_size), encoded(encoded_bound), compressed(lzma_stream_buffer_bound(encoded_bound));
+    vector<CTRACE_BLOCK> index;
+    uint64_t offset = sizeof(header);
+
+    uint8_t end_of_trace = 0;
+    while (!end_of_trace) {
+        uint32_t records = 0;
+        while ((records < records_per_block) && input.read(&block[(uint64_t)records * record_size]))
+            records++;
+        end_of_trace = (records < records_per_block);
+        if (records == 0)
+            break;
+
+        uint8_t *stored = block.data();
+        uint64_t stored_size = (uint64_t)records * record_size;
+        if (encoding == CTRACE_ENCODING_DELTA) {
+            stored_size = encode_delta_block(block.data(), records, record_size, encoded.data());
+            if (stored_size == 0) {
+                cerr << "[TRACE_CONVERT] branch flags other than 0 or 1 do not delta encode, use -encoding raw" << endl;
+                return 1;
+            }
+            stored = encoded.data();
+        }
+
+        if (compression == CTRACE_COMPRESSION_XZ) {
+            size_t compressed_size = 0;
+            lzma_ret ret = lzma_easy_buffer_encode(preset, LZMA_CHECK_CRC32, NULL, stored, stored_size,
+                                                   compressed.data(), &compressed_size, compressed.size());
+            if (ret != LZMA_OK) {
+                cerr << "[TRACE_CONVERT] xz encoding error " << ret << endl;
+                return 1;
+            }
+            stored = compressed.data();
+            stored_size = compressed_size;
+        }
+        write_raw(output, stored, stored_size);
+
+        CTRACE_BLOCK entry;
+        entry.offset = offset;
+        entry.size = stored_size;
+        index.push_back(entry);
+
+        offset += stored_size;
+        header.num_records += records;
+    }
+
+    header.num_blocks = index.size();
+    header.index_offset = offset;
+    write_raw(output, index.data(), index.size() * sizeof(CTRACE_BLOCK));
+
+    fseek(output, 0, SEEK_SET);
+    write_raw(output, &header, sizeof(header));
+    fclose(output);
+
+    cout << argv[optind+1] << ": " << header.num_records << " records in " << header.num_blocks << " blocks, " << offset + index.size() * sizeof(CTRACE_BLOCK) << " bytes" << endl;
+
+    return 0;
+}